@@ -39,12 +39,84 @@ function run_test {
 }
 
 
+# Run a test with --search. A test file containing a line such as
+# "// search: unsatisfiable" must also get that answer from the search.
+function run_search_test {
+
+    run_test "--search $1"
+
+    EXPECTED=`sed -n 's/^\/\/ *search: *//p' $1`
+
+    if [ -n "$EXPECTED" ]; then
+        if grep -qix "$EXPECTED" $OUTPUT_LOGS/$TEST; then
+            echo "[PASS] --search $1 is $EXPECTED"
+        else
+            echo "[FAIL] --search $1 is not $EXPECTED"
+            FINAL_RESULT=1
+        fi
+    fi
+
+}
+
+
+# Run a test which must be rejected with exit code 1, rather than crash or
+# succeed.
+function run_failing_test {
+
+    $BINARY $1 > $OUTPUT_LOGS/$TEST
+    RESULT=$?
+
+    if [ "$RESULT" = "1" ]; then
+        echo "[PASS] $1 rejected"
+    else
+        echo "[FAIL] $1 gave $RESULT, expected it to be rejected"
+        FINAL_RESULT=1
+    fi
+
+}
+
+
 
 for TEST in $TEST_FILES 
 do
 
     run_test $TEST_VECTORS/$TEST
+    run_test "--levelized $TEST_VECTORS/$TEST"
+    run_test "--parallel --threads 4 $TEST_VECTORS/$TEST"
+    run_test "--async --threads 4 $TEST_VECTORS/$TEST"
+    run_test "--components --threads 4 $TEST_VECTORS/$TEST"
+    run_test "--collapse $TEST_VECTORS/$TEST"
+    run_test "--fold --collapse $TEST_VECTORS/$TEST"
+    run_test "--cone $TEST_VECTORS/$TEST"
+    run_test "--renumber $TEST_VECTORS/$TEST"
+    run_search_test "$TEST_VECTORS/$TEST"
+
+    $BINARY --compile $TEST_VECTORS/$TEST -o $OUTPUT_LOGS/$TEST.satb > /dev/null
+    run_test "$OUTPUT_LOGS/$TEST.satb"
 
 done
 
+# A compiled file whose first relation reads a variable which does not
+# exist. The offset of the relations section is the sixth header field,
+# and the rhs is the second word of a relation.
+TEST=corrupt
+CORRUPT=$OUTPUT_LOGS/corrupt.satb
+cp $OUTPUT_LOGS/and.txt.satb $CORRUPT
+RELATIONS=`od -An -tu8 -j40 -N8 $CORRUPT`
+printf '\xff\xff\xff\x7f' | dd of=$CORRUPT bs=1 seek=$((RELATIONS + 4)) \
+                              conv=notrunc 2> /dev/null
+run_failing_test "$CORRUPT"
+
+# Compiling a compiled file must keep its expectations, so one which is not
+# met is still not met after recompiling it.
+TEST=recompiled
+UNMET=$OUTPUT_LOGS/unmet
+printf 'a = b & c\nexpect domain a == {}\nend\n' > $UNMET.txt
+$BINARY --compile $UNMET.txt -o $UNMET.satb > /dev/null
+$BINARY --compile $UNMET.satb -o $OUTPUT_LOGS/recompiled.satb > /dev/null
+run_failing_test "$OUTPUT_LOGS/recompiled.satb"
+
+TEST=batch
+run_test "--batch --threads 4 $TEST_VECTORS"
+
 exit $FINAL_RESULT
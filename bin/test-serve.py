@@ -0,0 +1,201 @@
+#!/usr/bin/python3
+
+"""
+Test client for `sats --serve`.
+
+Starts the solver daemon on a Unix domain socket, loads every test vector,
+and has several clients send it random queries at the same time. Each
+client pipelines all of its queries before reading any replies. Every
+reply is checked against running the solver from scratch on the same file
+with the query's constraints added.
+"""
+
+import os
+import re
+import sys
+import random
+import socket
+import argparse
+import tempfile
+import threading
+import subprocess
+import time
+
+KEYWORDS = set(["end", "expect", "domain"])
+
+
+def variables_of(path):
+    """
+    Returns the names of the variables which appear in a test vector, and
+    those which the vector does not already constrain. A second constraint
+    on a variable in a file replaces the first rather than adding to it, so
+    queries only constrain the latter.
+    """
+    text  = re.sub(r"//.*", "", open(path).read())
+    names = set(re.findall(r"[a-zA-Z][a-zA-Z_0-9]*", text)) - KEYWORDS
+    fixed = set(re.findall(r"^\s*([a-zA-Z][a-zA-Z_0-9]*)\s*(?:==|!=)", text,
+                           re.MULTILINE))
+    return sorted(names), sorted(names - fixed)
+
+
+def oracle(binary, path, constraints, watched):
+    """
+    Solve a test vector from scratch with extra unary constraints, and
+    return whether it conflicts, along with the domain of each watched
+    variable which is not {0,1}.
+    """
+    lines = open(path).read().split("\n")
+    at    = next(i for i, line in enumerate(lines)
+                 if line.strip().startswith("expect") or
+                    line.strip() == "end")
+
+    # Replace the file's own expectations with checks on the watched
+    # variables, which the solver reports whenever they are narrowed.
+    lines = lines[:at] + constraints + \
+            ["expect domain %s == {0 1}" % v for v in watched] + ["end"]
+
+    with tempfile.NamedTemporaryFile("w", suffix=".txt", delete=False) as f:
+        f.write("\n".join(lines) + "\n")
+
+    output = subprocess.run([binary, f.name], stdout=subprocess.PIPE,
+                            universal_newlines=True).stdout
+    os.unlink(f.name)
+
+    conflict = "Variables with empty domain: 0" not in output
+    narrowed = {}
+    for name, zero, one in re.findall(
+            r"Expected \{1 1\} for (\S+) \(\d+\), got \{(\d) (\d)\}", output):
+        narrowed[name] = "{%s}" % ",".join(
+            [v for v, ok in (("0", zero), ("1", one)) if ok == "1"])
+    return conflict, narrowed
+
+
+class Client(threading.Thread):
+    """
+    Sends a batch of pipelined queries down one connection and checks the
+    replies.
+    """
+
+    def __init__(self, args, circuits, seed):
+        threading.Thread.__init__(self)
+        self.args     = args
+        self.circuits = circuits
+        self.random   = random.Random(seed)
+        self.failures = []
+
+    def run(self):
+        queries = []
+        for _ in range(self.args.queries):
+            handle, path, names, free = self.random.choice(self.circuits)
+            constrained = self.random.sample(
+                free, min(len(free), self.random.randint(1, 3)))
+            constraints = ["%s %s %d" % (v, self.random.choice(["==", "!="]),
+                                         self.random.randint(0, 1))
+                           for v in constrained]
+            watched = self.random.sample(names, min(5, len(names)))
+            queries.append((handle, path, constraints, watched))
+
+        connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        connection.connect(self.args.socket)
+        stream = connection.makefile("rw")
+
+        for handle, path, constraints, watched in queries:
+            terms = [c.replace(" ", "") for c in constraints] + \
+                    ["%s={0,1}" % v for v in watched]
+            stream.write("query %d %s\n" % (handle, " ".join(terms)))
+        stream.flush()
+
+        for handle, path, constraints, watched in queries:
+            reply = stream.readline().split()
+            if len(reply) < 4 or reply[0] != "ok":
+                self.failures.append("bad reply %s" % " ".join(reply))
+                continue
+
+            conflict, narrowed = oracle(self.args.binary, path,
+                                        constraints, watched)
+
+            if conflict != (reply[1] == "conflict"):
+                self.failures.append("%s %s: expected %s, got %s" % (
+                    path, constraints,
+                    "conflict" if conflict else "consistent", reply[1]))
+                continue
+
+            got = dict(term.split("=", 1) for term in reply[4:])
+            if not conflict and got != narrowed:
+                self.failures.append("%s %s: expected %s, got %s" % (
+                    path, constraints, narrowed, got))
+
+        stream.write("quit\n")
+        stream.flush()
+        connection.close()
+
+
+def request(path, line):
+    """
+    Send one request on a new connection and return the reply.
+    """
+    connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    connection.connect(path)
+    stream = connection.makefile("rw")
+    stream.write(line + "\nquit\n")
+    stream.flush()
+    reply = stream.readline().strip()
+    connection.close()
+    return reply
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--binary",  default="./build/sats")
+    parser.add_argument("--tests",   default="./tests")
+    parser.add_argument("--socket",  default="./build/sats-test.sock")
+    parser.add_argument("--clients", type=int, default=4)
+    parser.add_argument("--queries", type=int, default=200)
+    parser.add_argument("--seed",    type=int, default=1)
+    args = parser.parse_args()
+
+    server = subprocess.Popen([args.binary, "--serve",
+                               "--socket", args.socket])
+
+    for _ in range(100):
+        if os.path.exists(args.socket):
+            break
+        time.sleep(0.05)
+
+    circuits = []
+    for name in sorted(os.listdir(args.tests)):
+        path  = os.path.join(args.tests, name)
+        reply = request(args.socket, "load " + path).split()
+        if reply[0] != "ok":
+            print("[FAIL] load %s: %s" % (path, " ".join(reply)))
+            server.kill()
+            return 1
+        circuits.append((int(reply[1]), path) + variables_of(path))
+
+    clients = [Client(args, circuits, args.seed + i)
+               for i in range(args.clients)]
+    for client in clients:
+        client.start()
+    for client in clients:
+        client.join()
+
+    print(request(args.socket, "stats"))
+    request(args.socket, "shutdown")
+    server.wait(timeout=10)
+
+    failures = [f for client in clients for f in client.failures]
+    for failure in failures[:20]:
+        print("[FAIL] " + failure)
+
+    if failures or server.returncode != 0:
+        print("[FAIL] %d of %d queries" % (len(failures),
+                                           args.clients * args.queries))
+        return 1
+
+    print("[PASS] %d queries from %d clients" % (args.clients * args.queries,
+                                                 args.clients))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
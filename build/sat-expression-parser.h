@@ -0,0 +1,129 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison interface for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_SATYY_BUILD_SAT_EXPRESSION_PARSER_H_INCLUDED
+# define YY_SATYY_BUILD_SAT_EXPRESSION_PARSER_H_INCLUDED
+/* Debug traces.  */
+#ifndef SATYYDEBUG
+# if defined YYDEBUG
+#if YYDEBUG
+#   define SATYYDEBUG 1
+#  else
+#   define SATYYDEBUG 0
+#  endif
+# else /* ! defined YYDEBUG */
+#  define SATYYDEBUG 0
+# endif /* ! defined YYDEBUG */
+#endif  /* ! defined SATYYDEBUG */
+#if SATYYDEBUG
+extern int satyydebug;
+#endif
+/* "%code requires" blocks.  */
+#line 7 "src/c/parser/sat-expression-parser.y"
+
+
+#include "sat-expression.h"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void * yyscan_t;
+#endif
+
+
+#line 68 "build/sat-expression-parser.h"
+
+/* Token kinds.  */
+#ifndef SATYYTOKENTYPE
+# define SATYYTOKENTYPE
+  enum satyytokentype
+  {
+    SATYYEMPTY = -2,
+    SATYYEOF = 0,                  /* "end of file"  */
+    SATYYerror = 256,              /* error  */
+    SATYYUNDEF = 257,              /* "invalid token"  */
+    TOK_ZERO = 258,                /* TOK_ZERO  */
+    TOK_ONE = 259,                 /* TOK_ONE  */
+    TOK_ID = 260,                  /* TOK_ID  */
+    TOK_END = 261,                 /* TOK_END  */
+    TOK_ASSIGN = 262,              /* TOK_ASSIGN  */
+    TOK_OP_OR = 263,               /* TOK_OP_OR  */
+    TOK_OP_NOR = 264,              /* TOK_OP_NOR  */
+    TOK_OP_XOR = 265,              /* TOK_OP_XOR  */
+    TOK_OP_NXOR = 266,             /* TOK_OP_NXOR  */
+    TOK_OP_NE = 267,               /* TOK_OP_NE  */
+    TOK_OP_EQ = 268,               /* TOK_OP_EQ  */
+    TOK_OP_AND = 269,              /* TOK_OP_AND  */
+    TOK_OP_NAND = 270,             /* TOK_OP_NAND  */
+    TOK_OP_NOT = 271,              /* TOK_OP_NOT  */
+    TOK_OP_IMP = 272,              /* TOK_OP_IMP  */
+    TOK_OB = 273,                  /* TOK_OB  */
+    TOK_CB = 274,                  /* TOK_CB  */
+    TOK_OP = 275,                  /* TOK_OP  */
+    TOK_CP = 276,                  /* TOK_CP  */
+    TOK_EXPECT = 277,              /* TOK_EXPECT  */
+    TOK_DOMAIN = 278,              /* TOK_DOMAIN  */
+    TOK_NOT = 279                  /* TOK_NOT  */
+  };
+  typedef enum satyytokentype satyytoken_kind_t;
+#endif
+
+/* Value type.  */
+#if ! defined SATYYSTYPE && ! defined SATYYSTYPE_IS_DECLARED
+union SATYYSTYPE
+{
+#line 70 "src/c/parser/sat-expression-parser.y"
+
+    char * vid;
+    int    integer;
+    sat_expression_node     * expr;
+    sat_expression_variable * var;
+
+#line 116 "build/sat-expression-parser.h"
+
+};
+typedef union SATYYSTYPE SATYYSTYPE;
+# define SATYYSTYPE_IS_TRIVIAL 1
+# define SATYYSTYPE_IS_DECLARED 1
+#endif
+
+
+
+
+int satyyparse (sat_context * ctx, yyscan_t scanner);
+
+
+#endif /* !YY_SATYY_BUILD_SAT_EXPRESSION_PARSER_H_INCLUDED  */
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "sat-expression.h"
+#include "sat-expression-parser.h"
+#define YYSTYPE SATYYSTYPE
+#include "sat-expression-scanner.h"
+typedef struct { FILE * in; const char * str; size_t pos; sat_context * ctx; } fs;
+struct fake_buffer { int dummy; };
+int satyylex_init_extra(sat_context * ctx, yyscan_t * s){ fs * f = calloc(1,sizeof(fs)); f->ctx=ctx; *s=f; return 0; }
+void satyyset_in(FILE * in, yyscan_t s){ ((fs*)s)->in = in; }
+int satyylex_destroy(yyscan_t s){ free(s); return 0; }
+YY_BUFFER_STATE satyy_scan_string(const char * str, yyscan_t s){ ((fs*)s)->str=str; ((fs*)s)->pos=0; return malloc(sizeof(struct fake_buffer)); }
+void satyy_delete_buffer(YY_BUFFER_STATE b, yyscan_t s){ free(b); }
+static int gc(fs * f){ if(f->str){ if(!f->str[f->pos]) return EOF; return (unsigned char)f->str[f->pos++]; } return fgetc(f->in); }
+static void ug(int c, fs * f){ if(c==EOF) return; if(f->str) f->pos--; else ungetc(c,f->in); }
+int satyylex(SATYYSTYPE * lval, yyscan_t s){
+    fs * f = s;
+    int c;
+again:
+    c = gc(f);
+    if(c == EOF) return 0;
+    if(isspace(c)) goto again;
+    if(c == '/'){ int d = gc(f); if(d=='/'){ while((c=gc(f))!='\n' && c!=EOF); goto again;} ug(d,f); }
+    if(isalpha(c)){
+        char buf[4096]; int n=0; buf[n++]=c;
+        while((c=gc(f))!=EOF && (isalnum(c)||c=='_')) buf[n++]=c;
+        ug(c,f);
+        buf[n]=0;
+        if(!strcmp(buf,"end")) return TOK_END;
+        if(!strcmp(buf,"expect")) return TOK_EXPECT;
+        if(!strcmp(buf,"domain")) return TOK_DOMAIN;
+        lval->vid = sat_intern_name(f->ctx, buf, n);
+        return TOK_ID;
+    }
+    switch(c){
+    case '0': return TOK_ZERO; case '1': return TOK_ONE;
+    case '{': return TOK_OP; case '}': return TOK_CP;
+    case '(': return TOK_OB; case ')': return TOK_CB;
+    case '|': return TOK_OP_OR; case '^': return TOK_OP_XOR; case '&': return TOK_OP_AND;
+    case '~': { int d=gc(f); if(d=='|') return TOK_OP_NOR; if(d=='^') return TOK_OP_NXOR; if(d=='&') return TOK_OP_NAND; ug(d,f); return TOK_OP_NOT; }
+    case '!': gc(f); return TOK_OP_NE;
+    case '=': { int d=gc(f); if(d=='=') return TOK_OP_EQ; ug(d,f); return TOK_ASSIGN; }
+    case '-': gc(f); return TOK_OP_IMP;
+    }
+    printf("[ERROR] Unrecognized character: %c\n", c);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include <stdio.h>
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void * yyscan_t;
+#endif
+typedef struct fake_buffer * YY_BUFFER_STATE;
+int satyylex_init_extra(sat_context * ctx, yyscan_t * s);
+void satyyset_in(FILE * f, yyscan_t s);
+int satyylex_destroy(yyscan_t s);
+YY_BUFFER_STATE satyy_scan_string(const char * str, yyscan_t s);
+void satyy_delete_buffer(YY_BUFFER_STATE b, yyscan_t s);
+int satyylex(YYSTYPE * lval, yyscan_t s);
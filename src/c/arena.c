@@ -0,0 +1,179 @@
+
+#include <assert.h>
+#include <string.h>
+
+#include "arena.h"
+
+//! All allocations are rounded up to a multiple of this many bytes.
+#define ARENA_ALIGN 16
+
+
+/*!
+@brief Create a new block with at least size bytes of usable memory.
+@param [in] size - Number of usable bytes.
+@returns A pointer to the new block or NULL if the allocation fails.
+*/
+static arena_block * arena_new_block(
+    size_t size
+){
+    // The header is padded so the data which follows it stays aligned.
+    size_t header = (sizeof(arena_block) + ARENA_ALIGN - 1) &
+                    ~(size_t)(ARENA_ALIGN - 1);
+
+    arena_block * tr = malloc(header + size);
+
+    if(tr == NULL) {
+        return NULL;
+    }
+
+    tr -> next = NULL;
+    tr -> size = size;
+    tr -> used = 0;
+    tr -> data = (unsigned char *)tr + header;
+
+    return tr;
+}
+
+
+/*!
+@brief Create a new empty arena.
+@param [in] block_size - Size in bytes of the blocks to allocate from. Larger
+allocations get a block of their own.
+@returns a new empty arena.
+*/
+arena * arena_new(
+    size_t block_size
+){
+    assert(block_size > 0);
+
+    arena * tr = calloc(1, sizeof(arena));
+
+    tr -> head       = NULL;
+    tr -> block_size = block_size;
+
+    return tr;
+}
+
+
+/*!
+@brief Free an arena and every object allocated from it.
+@param [in] tofree - The arena to free.
+*/
+void arena_free(
+    arena * tofree
+){
+    arena_block * walker = tofree -> head;
+
+    while(walker != NULL) {
+        arena_block * next = walker -> next;
+        free(walker);
+        walker = next;
+    }
+
+    free(tofree);
+}
+
+
+/*!
+@brief Free every object allocated from an arena, but keep the arena.
+@param [in] a - The arena to reset.
+*/
+void arena_reset(
+    arena * a
+){
+    if(a -> head == NULL) {
+        return;
+    }
+
+    arena_block * walker = a -> head -> next;
+
+    while(walker != NULL) {
+        arena_block * next = walker -> next;
+        free(walker);
+        walker = next;
+    }
+
+    a -> head -> next = NULL;
+    a -> head -> used = 0;
+    a -> bytes_used   = 0;
+}
+
+
+/*!
+@brief Allocate zeroed memory from the arena.
+@param [in] a - The arena to allocate from.
+@param [in] size - Number of bytes to allocate.
+@returns A pointer to the allocated memory or NULL if it cannot be allocated.
+*/
+void * arena_alloc(
+    arena * a,
+    size_t  size
+){
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if(a -> head == NULL || a -> head -> used + size > a -> head -> size) {
+
+        size_t        block_size = size > a -> block_size ? size
+                                                          : a -> block_size;
+        arena_block * block      = arena_new_block(block_size);
+
+        if(block == NULL) {
+            return NULL;
+        }
+
+        if(size > a -> block_size && a -> head != NULL) {
+            // Keep allocating from the current block afterwards, rather than
+            // throwing away whatever is left of it.
+            block -> next     = a -> head -> next;
+            a -> head -> next = block;
+        } else {
+            block -> next = a -> head;
+            a -> head     = block;
+        }
+
+        block -> used = size;
+        a -> allocations += 1;
+        a -> bytes_used  += size;
+        if(a -> bytes_used > a -> peak_bytes) {
+            a -> peak_bytes = a -> bytes_used;
+        }
+
+        memset(block -> data, 0, size);
+        return block -> data;
+    }
+
+    void * tr = a -> head -> data + a -> head -> used;
+
+    a -> head -> used += size;
+    a -> allocations  += 1;
+    a -> bytes_used   += size;
+
+    if(a -> bytes_used > a -> peak_bytes) {
+        a -> peak_bytes = a -> bytes_used;
+    }
+
+    memset(tr, 0, size);
+    return tr;
+}
+
+
+/*!
+@brief Copy a string of known length into the arena.
+@param [in] a - The arena to allocate from.
+@param [in] str - The string to copy. Need not be null terminated.
+@param [in] len - Number of characters to copy.
+@returns A null terminated copy of the string.
+*/
+char * arena_strndup(
+    arena      * a,
+    const char * str,
+    size_t       len
+){
+    char * tr = arena_alloc(a, len + 1);
+
+    if(tr != NULL) {
+        memcpy(tr, str, len);
+    }
+
+    return tr;
+}
@@ -0,0 +1,107 @@
+
+#include <stdlib.h>
+
+#ifndef ARENA_H
+#define ARENA_H
+
+
+/*!
+@defgroup gr-arena Arena Allocator
+
+@brief A bump pointer allocator for objects which all die together.
+
+@details Memory is handed out from large blocks by advancing a pointer, so
+allocating is a handful of instructions and individual objects are never
+freed. The whole arena is released at once with arena_free, which only
+walks the (few) blocks rather than every object.
+
+@addtogroup gr-arena
+@{
+*/
+
+/*!
+@brief A single block of memory from which allocations are made.
+*/
+typedef struct arena_block_t arena_block;
+struct arena_block_t {
+    arena_block   * next;   //<! The previously filled block.
+    size_t          size;   //<! Number of usable bytes in data.
+    size_t          used;   //<! Number of bytes of data handed out.
+    unsigned char * data;   //<! Start of the usable memory in the block.
+};
+
+
+/*!
+@brief An arena, along with statistics on how it has been used.
+*/
+typedef struct arena_t {
+    arena_block * head;         //<! Block currently being allocated from.
+    size_t        block_size;   //<! Default size of new blocks.
+    size_t        allocations;  //<! Number of calls to arena_alloc.
+    size_t        bytes_used;   //<! Bytes currently handed out.
+    size_t        peak_bytes;   //<! Largest value bytes_used has taken.
+} arena;
+
+
+/*!
+@brief Create a new empty arena.
+@param [in] block_size - Size in bytes of the blocks to allocate from. Larger
+allocations get a block of their own.
+@returns a new empty arena.
+*/
+arena * arena_new(
+    size_t block_size
+);
+
+
+/*!
+@brief Free an arena and every object allocated from it.
+@param [in] tofree - The arena to free.
+*/
+void arena_free(
+    arena * tofree
+);
+
+
+/*!
+@brief Free every object allocated from an arena, but keep the arena.
+@details One block is kept for re-use so an arena which is repeatedly
+filled and reset does not go back to the system allocator. Allocation
+statistics are kept, apart from bytes_used which returns to zero.
+@param [in] a - The arena to reset.
+*/
+void arena_reset(
+    arena * a
+);
+
+
+/*!
+@brief Allocate zeroed memory from the arena.
+@details The returned memory is aligned suitably for any object type, and
+lives until the arena is freed.
+@param [in] a - The arena to allocate from.
+@param [in] size - Number of bytes to allocate.
+@returns A pointer to the allocated memory or NULL if it cannot be allocated.
+*/
+void * arena_alloc(
+    arena * a,
+    size_t  size
+);
+
+
+/*!
+@brief Copy a string of known length into the arena.
+@param [in] a - The arena to allocate from.
+@param [in] str - The string to copy. Need not be null terminated.
+@param [in] len - Number of characters to copy.
+@returns A null terminated copy of the string.
+*/
+char * arena_strndup(
+    arena      * a,
+    const char * str,
+    size_t       len
+);
+
+/*! @} */
+
+#endif
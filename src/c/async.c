@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "async.h"
+#include "deque.h"
+
+#ifdef _OPENMP
+
+/*!
+@brief State shared by every thread of sat_solve_async.
+*/
+typedef struct sat_async_state_t {
+    sat_imp_matrix * imp_mat;       //!< The matrix being solved.
+    deque         ** deques;        //!< One worklist per thread.
+    unsigned char  * pending;       //!< Set iff a relation is in a deque.
+    unsigned int     threads;       //!< Number of threads and deques.
+    long             outstanding;   //!< Relations pending or being revised.
+    int              conflict;      //!< Set when a domain becomes empty.
+} sat_async_state;
+
+
+/*!
+@brief Push a relation onto a thread's deque, unless it is already pending.
+*/
+static void sat_async_enqueue(
+    sat_async_state * state,
+    deque           * mine,
+    sat_var_idx       relation
+){
+    if(__atomic_load_n(&state -> pending[relation], __ATOMIC_RELAXED) ||
+       __atomic_exchange_n(&state -> pending[relation], SAT_TRUE,
+                           __ATOMIC_SEQ_CST)) {
+        return;
+    }
+
+    // Count the relation before it can be taken, so the count can never
+    // reach zero while it is still waiting.
+    __atomic_add_fetch(&state -> outstanding, 1, __ATOMIC_SEQ_CST);
+    deque_push(mine, relation);
+}
+
+
+/*!
+@brief Add every relation which could be narrowed by a change to the
+domain of variable to a thread's deque.
+@details This is the relation which assigns to the variable (unless it is an
+input) and all of the relations which read it, apart from `skip`.
+*/
+static void sat_async_enqueue_dependents(
+    sat_async_state * state,
+    deque           * mine,
+    sat_var_idx       variable,
+    sat_var_idx       skip
+){
+    sat_imp_matrix * imp_mat = state -> imp_mat;
+
+    if(variable != skip && !sat_is_input(imp_mat, variable)) {
+        sat_async_enqueue(state, mine, variable);
+    }
+
+    unsigned int f   = imp_mat -> fanout_start[variable    ];
+    unsigned int end = imp_mat -> fanout_start[variable + 1];
+
+    for (; f < end; f += 1) {
+        if(imp_mat -> fanout[f] != skip) {
+            sat_async_enqueue(state, mine, imp_mat -> fanout[f]);
+        }
+    }
+}
+
+
+/*!
+@brief Revise one relation taken from a deque.
+@details The pending flag is cleared before the domains are read. A thread
+which narrows one of them afterwards enqueues the relation again.
+*/
+static void sat_async_revise(
+    sat_async_state * state,
+    deque           * mine,
+    sat_var_idx       relation
+){
+    sat_imp_matrix * imp_mat = state -> imp_mat;
+
+    __atomic_store_n(&state -> pending[relation], SAT_FALSE,
+                     __ATOMIC_SEQ_CST);
+
+    t_sat_bool revised = sat_solve_arc_reduce_shared(imp_mat, relation);
+
+    if(revised) {
+
+        if(sat_load_domain_bits(imp_mat, relation) == 0) {
+            __atomic_store_n(&state -> conflict, 1, __ATOMIC_RELAXED);
+            return;
+        }
+
+        sat_relation * r = &imp_mat -> relations[relation];
+
+        if(revised & SAT_REVISED_ASSIGNEE) {
+            sat_async_enqueue_dependents(state, mine, relation, relation);
+        }
+        if(revised & SAT_REVISED_LHS) {
+            sat_async_enqueue_dependents(state, mine, r -> lhs, relation);
+        }
+        if(revised & SAT_REVISED_RHS) {
+            sat_async_enqueue_dependents(state, mine, r -> rhs, relation);
+        }
+    }
+}
+
+
+/*!
+@brief The loop run by each thread of sat_solve_async.
+@details Takes work from its own deque first, then tries to steal from the
+others, starting with its neighbour. It only stops once no relation is
+pending or being revised anywhere, or a conflict has been found.
+*/
+static void sat_async_worker(
+    sat_async_state * state,
+    unsigned int      me
+){
+    deque * mine = state -> deques[me];
+
+    while(!__atomic_load_n(&state -> conflict, __ATOMIC_RELAXED)) {
+
+        unsigned int relation = deque_take(mine);
+        unsigned int victim   = 1;
+
+        while(relation == DEQUE_EMPTY && victim < state -> threads) {
+            relation = deque_steal(state -> deques[(me + victim) %
+                                                   state -> threads]);
+            if(relation != DEQUE_ABORT) {
+                victim += relation == DEQUE_EMPTY;
+            } else {
+                relation = DEQUE_EMPTY;
+            }
+        }
+
+        if(relation == DEQUE_EMPTY) {
+            if(__atomic_load_n(&state -> outstanding, __ATOMIC_SEQ_CST) == 0) {
+                break;
+            }
+            continue;
+        }
+
+        sat_async_revise(state, mine, relation);
+
+        // Only stop counting this relation once its dependents have been
+        // counted.
+        __atomic_sub_fetch(&state -> outstanding, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+#endif
+
+
+/*!
+@brief Solve the constraint problem using asynchronous, work stealing AC-3.
+@details Relations are dealt out to the threads' deques in contiguous
+blocks, so each thread starts on its own part of the netlist.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] threads - How many threads to use, or 0 for the OpenMP default.
+@returns True if the system is solvable.
+*/
+t_sat_bool sat_solve_async(
+    sat_imp_matrix * imp_mat,
+    unsigned int     threads
+){
+#ifdef _OPENMP
+    if(sat_any_domain_empty(imp_mat)) {
+        return SAT_FALSE;
+    }
+
+    if(imp_mat -> fanout_stale) {
+        sat_build_fanout(imp_mat);
+    }
+
+    if(threads == 0) {
+        threads = omp_get_max_threads();
+    }
+
+    unsigned int    n = imp_mat -> variable_count;
+    sat_async_state state;
+    unsigned int    t;
+
+    state.imp_mat     = imp_mat;
+    state.threads     = threads;
+    state.outstanding = 0;
+    state.conflict    = 0;
+    state.pending     = calloc(n > 0 ? n : 1, 1);
+    state.deques      = calloc(threads, sizeof(deque*));
+
+    for(t = 0; t < threads; t += 1) {
+        state.deques[t] = deque_new(n / threads + 1);
+    }
+
+    #pragma omp parallel num_threads(threads)
+    {
+        // OpenMP may give us fewer threads than we asked for.
+        unsigned int team  = omp_get_num_threads();
+        unsigned int me    = omp_get_thread_num();
+        sat_var_idx  first = (unsigned long)n *  me      / team;
+        sat_var_idx  last  = (unsigned long)n * (me + 1) / team;
+        sat_var_idx  i;
+
+        if(me == 0) {
+            state.threads = team;
+        }
+
+        // Push in reverse so the lowest indexes are taken first.
+        for(i = last; i > first; i -= 1) {
+            if(!sat_is_input(imp_mat, i - 1)) {
+                sat_async_enqueue(&state, state.deques[me], i - 1);
+            }
+        }
+
+        // Nobody may look for work until every deque has been filled, or
+        // the count could reach zero too early.
+        #pragma omp barrier
+
+        sat_async_worker(&state, me);
+    }
+
+    for(t = 0; t < threads; t += 1) {
+        deque_free(state.deques[t]);
+    }
+    free(state.deques);
+    free(state.pending);
+
+    return !state.conflict;
+#else
+    return sat_solve(imp_mat);
+#endif
+}
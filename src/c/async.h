@@ -0,0 +1,41 @@
+
+#include "imp-matrix.h"
+
+#ifndef H_ASYNC
+#define H_ASYNC
+
+/*!
+@defgroup gr-async Asynchronous Solver
+
+@brief Multi-threaded AC-3 in which each thread owns a worklist and steals
+from the others when it runs out of work.
+
+@details Unlike sat_solve_parallel there are no levels and no barriers, so
+it copes with cyclic and deeply chained problems. Every relation has an
+atomic pending flag, so it is only ever waiting in one worklist at a time,
+and domains are narrowed with an atomic AND so concurrent revisions can
+only remove values. A shared count of relations which are pending or being
+revised tells the threads when there is nothing left to do.
+
+@addtogroup gr-async
+@{
+*/
+
+
+/*!
+@brief Solve the constraint problem using asynchronous, work stealing AC-3.
+@details Gives exactly the same domains as sat_solve when the problem has
+no conflict. All threads stop as soon as any of them empties a domain.
+Falls back to sat_solve if built without OpenMP.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] threads - How many threads to use, or 0 for the OpenMP default.
+@returns True if the system is solvable.
+*/
+t_sat_bool sat_solve_async(
+    sat_imp_matrix * imp_mat,
+    unsigned int     threads
+);
+
+/*! @} */
+
+#endif
@@ -0,0 +1,227 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "batch.h"
+
+/*!
+@brief Create a new, empty batch.
+@returns A pointer to the batch, to be freed with sat_free_batch.
+*/
+sat_batch * sat_new_batch()
+{
+    return calloc(1, sizeof(sat_batch));
+}
+
+
+/*!
+@brief Free a batch and all of its records.
+@param [in] tofree - The batch to free.
+*/
+void sat_free_batch(
+    sat_batch * tofree
+){
+    unsigned int i;
+    for(i = 0; i < tofree -> length; i += 1) {
+        free(tofree -> results[i].path);
+    }
+    free(tofree -> results);
+    free(tofree);
+}
+
+
+/*!
+@brief Append a single file to a batch.
+@param [inout] batch - The batch to add to.
+@param [in] path - The file, which is copied.
+*/
+static void sat_batch_add_file(
+    sat_batch  * batch,
+    const char * path
+){
+    if(batch -> length == batch -> capacity) {
+        batch -> capacity = batch -> capacity ? batch -> capacity * 2 : 64;
+        batch -> results  = realloc(batch -> results,
+                                    batch -> capacity *
+                                    sizeof(sat_batch_result));
+    }
+
+    sat_batch_result * result = &batch -> results[batch -> length ++];
+    memset(result, 0, sizeof(sat_batch_result));
+    result -> path = strdup(path);
+}
+
+
+//! qsort comparison function for an array of strings.
+static int sat_compare_names(const void * a, const void * b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+
+/*!
+@brief Add a file, or every file in a directory, to a batch.
+@param [inout] batch - The batch to add to.
+@param [in] path - A file or directory.
+@returns SAT_FALSE if path is a directory which could not be read.
+*/
+t_sat_bool sat_batch_add_path(
+    sat_batch  * batch,
+    const char * path
+){
+    struct stat info;
+
+    if(stat(path, &info) != 0 || !S_ISDIR(info.st_mode)) {
+        // Missing files are reported in their result record.
+        sat_batch_add_file(batch, path);
+        return SAT_TRUE;
+    }
+
+    DIR * dir = opendir(path);
+    if(dir == NULL) {
+        return SAT_FALSE;
+    }
+
+    char         ** names    = NULL;
+    unsigned int    count    = 0;
+    unsigned int    capacity = 0;
+    struct dirent * entry;
+
+    while((entry = readdir(dir)) != NULL) {
+
+        if(entry -> d_name[0] == '.') {
+            continue;
+        }
+
+        size_t length = strlen(path) + strlen(entry -> d_name) + 2;
+        char * name   = malloc(length);
+        snprintf(name, length, "%s/%s", path, entry -> d_name);
+
+        if(stat(name, &info) != 0 || !S_ISREG(info.st_mode)) {
+            free(name);
+            continue;
+        }
+
+        if(count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            names    = realloc(names, capacity * sizeof(char*));
+        }
+        names[count ++] = name;
+    }
+
+    closedir(dir);
+
+    qsort(names, count, sizeof(char*), sat_compare_names);
+
+    unsigned int i;
+    for(i = 0; i < count; i += 1) {
+        sat_batch_add_file(batch, names[i]);
+        free(names[i]);
+    }
+    free(names);
+
+    return SAT_TRUE;
+}
+
+
+/*!
+@brief Parse and solve one file of a batch, in a context of its own.
+@param [inout] result - The record of the file to solve.
+@param [in] levelized - Solve with sat_solve_levelized rather than sat_solve.
+@param [in] search - Also decide satisfiability with sat_search.
+*/
+static void sat_solve_batch_file(
+    sat_batch_result * result,
+    t_sat_bool         levelized,
+    t_sat_bool         search
+){
+    sat_context * ctx         = sat_new_context();
+    int           load_result = sat_load_file(ctx, result -> path);
+
+    if(load_result != SAT_LOAD_OK) {
+        result -> status = load_result == SAT_LOAD_UNREADABLE ?
+                           SAT_BATCH_UNREADABLE : SAT_BATCH_SYNTAX_ERROR;
+        sat_free_context(ctx);
+        return;
+    }
+
+    sat_imp_matrix * imp_matrix = sat_get_imp_matrix(ctx);
+
+    if(levelized) {
+        sat_solve_levelized(imp_matrix);
+    } else {
+        sat_solve(imp_matrix);
+    }
+
+    result -> variables    = sat_get_variable_count(ctx);
+    result -> empty        = sat_count_empty_domains(imp_matrix);
+    result -> expectations = sat_expectations_met(ctx, SAT_FALSE);
+    result -> status       = result -> empty ? SAT_BATCH_CONFLICT
+                                             : SAT_BATCH_CONSISTENT;
+
+    if(search) {
+        result -> status = sat_search(imp_matrix, NULL) ?
+                           SAT_BATCH_SATISFIABLE : SAT_BATCH_UNSATISFIABLE;
+    }
+
+    sat_free_context(ctx);
+}
+
+
+/*!
+@brief Solve every file in a batch, filling in its record.
+@details Files are handed out one at a time, since their sizes vary too
+much for a static split to keep every thread busy.
+@param [inout] batch - The batch to solve.
+@param [in] levelized - Solve with sat_solve_levelized rather than sat_solve.
+@param [in] search - Also decide satisfiability with sat_search.
+@param [in] threads - How many threads to use, or 0 for the OpenMP default.
+*/
+void sat_solve_batch(
+    sat_batch    * batch,
+    t_sat_bool     levelized,
+    t_sat_bool     search,
+    unsigned int   threads
+){
+    int i;
+
+#ifdef _OPENMP
+    if(threads == 0) {
+        threads = omp_get_max_threads();
+    }
+#endif
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+    for(i = 0; i < (int)batch -> length; i += 1) {
+        sat_solve_batch_file(&batch -> results[i], levelized, search);
+    }
+}
+
+
+/*!
+@brief Returns a short name for a batch status, as used in result records.
+@param [in] status - The status to name.
+@returns A constant string.
+*/
+const char * sat_batch_status_name(
+    sat_batch_status status
+){
+    switch(status) {
+        case SAT_BATCH_CONSISTENT   : return "consistent";
+        case SAT_BATCH_CONFLICT     : return "conflict";
+        case SAT_BATCH_SATISFIABLE  : return "satisfiable";
+        case SAT_BATCH_UNSATISFIABLE: return "unsatisfiable";
+        case SAT_BATCH_SYNTAX_ERROR : return "syntax-error";
+        case SAT_BATCH_UNREADABLE   : return "unreadable";
+    }
+    return "unknown";
+}
@@ -0,0 +1,113 @@
+
+#include "sats.h"
+
+#ifndef H_BATCH
+#define H_BATCH
+
+/*!
+@defgroup gr-batch Batch Solving
+
+@brief Solve many independent problem files in one process.
+
+@details Each file is parsed into its own sat_context, so files share no
+state and can be solved on different threads at the same time. Files are
+handed out to a pool of OpenMP threads one at a time, which keeps every
+thread busy even when the files differ a lot in size. Each thread solves
+its file with a single threaded solver; the parallelism comes from solving
+many files at once.
+
+@addtogroup gr-batch
+@{
+*/
+
+//! What happened to one file of a batch.
+typedef enum t_sat_batch_status {
+    SAT_BATCH_CONSISTENT    = 0, //!< No domain became empty.
+    SAT_BATCH_CONFLICT      = 1, //!< At least one domain became empty.
+    SAT_BATCH_SATISFIABLE   = 2, //!< Search found a satisfying assignment.
+    SAT_BATCH_UNSATISFIABLE = 3, //!< Search proved there is none.
+    SAT_BATCH_SYNTAX_ERROR  = 4, //!< The file could not be parsed.
+    SAT_BATCH_UNREADABLE    = 5  //!< The file could not be opened.
+} sat_batch_status;
+
+
+/*!
+@brief The result record for one file of a batch.
+*/
+typedef struct sat_batch_result_t {
+    char             * path;         //!< The file, owned by the result.
+    sat_batch_status   status;       //!< What happened to it.
+    unsigned int       variables;    //!< Number of variables in the problem.
+    unsigned int       empty;        //!< Variables left with empty domains.
+    t_sat_bool         expectations; //!< Were all expectations met?
+} sat_batch_result;
+
+
+/*!
+@brief A growable list of files to solve, and their results.
+*/
+typedef struct sat_batch_t {
+    sat_batch_result * results;  //!< One record per file, in input order.
+    unsigned int       length;   //!< Number of files in the batch.
+    unsigned int       capacity; //!< Number of records allocated.
+} sat_batch;
+
+
+/*!
+@brief Create a new, empty batch.
+@returns A pointer to the batch, to be freed with sat_free_batch.
+*/
+sat_batch * sat_new_batch();
+
+
+/*!
+@brief Free a batch and all of its records.
+@param [in] tofree - The batch to free.
+*/
+void sat_free_batch(
+    sat_batch * tofree
+);
+
+
+/*!
+@brief Add a file, or every file in a directory, to a batch.
+@details Directories are not searched recursively. Their files are added in
+name order, skipping hidden files, so the records come out in a
+predictable order.
+@param [inout] batch - The batch to add to.
+@param [in] path - A file or directory.
+@returns SAT_FALSE if path is a directory which could not be read.
+*/
+t_sat_bool sat_batch_add_path(
+    sat_batch  * batch,
+    const char * path
+);
+
+
+/*!
+@brief Solve every file in a batch, filling in its record.
+@param [inout] batch - The batch to solve.
+@param [in] levelized - Solve with sat_solve_levelized rather than sat_solve.
+@param [in] search - Also decide satisfiability with sat_search.
+@param [in] threads - How many threads to use, or 0 for the OpenMP default.
+*/
+void sat_solve_batch(
+    sat_batch    * batch,
+    t_sat_bool     levelized,
+    t_sat_bool     search,
+    unsigned int   threads
+);
+
+
+/*!
+@brief Returns a short name for a batch status, as used in result records.
+@param [in] status - The status to name.
+@returns A constant string.
+*/
+const char * sat_batch_status_name(
+    sat_batch_status status
+);
+
+/*! @} */
+
+#endif
@@ -0,0 +1,179 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "imp-matrix.h"
+#include "incremental.h"
+
+/*!
+@file incremental-queries.c
+@brief Compares answering queries by rebuilding and re-solving the matrix
+each time against using the incremental solver.
+@details Each query assumes values for a handful of random variables. For
+every query the domains found both ways are compared, and at the end the
+incremental solver's matrix must be back in its base state. Half way
+through, more gates are added to the circuit between queries. Every fourth
+query assumes a gate and its operands take values the gate cannot give,
+so conflicting queries are rolled back too.
+
+Usage: bench-incremental-queries [gate count] [queries] [assumptions]
+*/
+
+
+//! Returns the current time in seconds.
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+//! Add gates first..last-1 of the benchmark netlist to a matrix.
+static void add_gates(
+    sat_imp_matrix  * m,
+    sat_incremental * inc,
+    unsigned int      first,
+    unsigned int      last
+){
+    unsigned int i;
+
+    srand(first);
+    for(i = first; i < last; i += 1) {
+        unsigned int  window = i < 4096 ? i : 4096;
+        sat_var_idx   l      = i - 1 - rand() % window;
+        sat_var_idx   r      = i - 1 - rand() % window;
+        sat_binary_op op     = SAT_OR + rand() % 6;
+
+        if(inc != NULL) {
+            sat_incremental_add_relation(inc, i, l, op, r);
+        } else {
+            sat_add_relation(m, i, l, op, r);
+        }
+    }
+}
+
+
+int main(int argc, char ** argv) {
+
+    unsigned int n       = argc > 1 ? atoi(argv[1]) : 200000;
+    unsigned int queries = argc > 2 ? atoi(argv[2]) : 100;
+    unsigned int assume  = argc > 3 ? atoi(argv[3]) : 4;
+    unsigned int inputs  = n / 16 + 2;
+    unsigned int half    = n - n / 4;
+
+    sat_imp_matrix  * base = sat_new_imp_matrix(inputs);
+    add_gates(base, NULL, inputs, half);
+    sat_incremental * inc  = sat_new_incremental(base);
+
+    unsigned int * vars   = calloc(assume, sizeof(unsigned int));
+    t_sat_bool   * values = calloc(assume, sizeof(t_sat_bool));
+    unsigned int   words  = 0;
+    double         fresh_time = 0, inc_time = 0;
+    unsigned int   mismatches = 0, conflicts = 0;
+    unsigned int   q, a;
+
+    sat_domain_word * base_domains = NULL;
+
+    for(q = 0; q < queries; q += 1) {
+
+        unsigned int size = q < queries / 2 ? half : n;
+
+        if(q == queries / 2) {
+            double t0 = now();
+            add_gates(base, inc, half, n);
+            sat_incremental_settle(inc);
+            inc_time += now() - t0;
+        }
+
+        // Keep a copy of the base state to check rollback against.
+        if(q == queries / 2 || q == 0) {
+            words = (size + SAT_DOMAINS_PER_WORD - 1) / SAT_DOMAINS_PER_WORD;
+            free(base_domains);
+            base_domains = malloc(words * sizeof(sat_domain_word));
+            memcpy(base_domains, base -> domains,
+                   words * sizeof(sat_domain_word));
+        }
+
+        srand(1000 + q);
+        for(a = 0; a < assume; a += 1) {
+            vars  [a] = rand() % size;
+            values[a] = rand() & 1;
+        }
+
+        // Contradict a random gate: assume its operands, and the opposite
+        // of the value it gives them.
+        if(q % 4 == 3 && assume >= 3) {
+            sat_var_idx    g = inputs + rand() % (size - inputs);
+            sat_relation * r = &base -> relations[g];
+
+            vars[0] = r -> lhs; values[0] = rand() & 1;
+            vars[1] = r -> rhs; values[1] = r -> lhs == r -> rhs ?
+                                            values[0] : rand() & 1;
+            vars[2] = g;
+            values[2] = !((sat_relation_truth(r) >>
+                           (2 * values[0] + values[1])) & 1);
+        }
+
+        // The old way: build the circuit again and solve it from scratch.
+        double t0 = now();
+        sat_imp_matrix * fresh = sat_new_imp_matrix(inputs);
+        add_gates(fresh, NULL, inputs, half);
+        if(size == n) {
+            add_gates(fresh, NULL, half, n);
+        }
+        for(a = 0; a < assume; a += 1) {
+            sat_set_domain_bits(fresh, vars[a],
+                                sat_get_domain_bits(fresh, vars[a]) &
+                                (values[a] ? SAT_DOMAIN_1 : SAT_DOMAIN_0));
+        }
+        t_sat_bool ok_fresh = sat_solve(fresh);
+        double t1 = now();
+
+        // The incremental way.
+        t_sat_bool ok_inc = SAT_TRUE;
+        for(a = 0; a < assume; a += 1) {
+            ok_inc &= sat_incremental_assume(inc, vars[a], values[a]);
+        }
+        ok_inc &= sat_incremental_propagate(inc);
+        double t2 = now();
+
+        fresh_time += t1 - t0;
+        inc_time   += t2 - t1;
+
+        if(ok_fresh != ok_inc) {
+            mismatches += 1;
+        } else if(ok_fresh &&
+                  memcmp(fresh -> domains, base -> domains,
+                         words * sizeof(sat_domain_word))) {
+            mismatches += 1;
+        }
+        conflicts += !ok_fresh;
+
+        t0 = now();
+        sat_incremental_rollback(inc);
+        inc_time += now() - t0;
+
+        sat_free_imp_matrix(fresh);
+    }
+
+    t_sat_bool restored = base_domains == NULL ||
+                          !memcmp(base_domains, base -> domains,
+                                  words * sizeof(sat_domain_word));
+
+    printf("Gates: %u, queries: %u (%u conflicting), assumptions: %u\n",
+           n, queries, conflicts, assume);
+    printf("Rebuild and solve: %8.3f ms/query\n", fresh_time * 1e3 / queries);
+    printf("Incremental:       %8.3f ms/query\n", inc_time   * 1e3 / queries);
+    printf("Mismatches: %u, base state %s\n", mismatches,
+           restored ? "restored" : "NOT restored!");
+
+    sat_free_incremental(inc);
+    sat_free_imp_matrix(base);
+    free(base_domains);
+    free(vars);
+    free(values);
+
+    return mismatches > 0 || !restored;
+}
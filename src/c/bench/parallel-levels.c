@@ -0,0 +1,137 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "imp-matrix.h"
+#include "levels.h"
+
+/*!
+@file parallel-levels.c
+@brief Compares sat_solve, sat_solve_levelized and sat_solve_parallel with
+increasing thread counts on the same random netlist.
+@details The netlist is built so that it is satisfiable: a random input
+vector is simulated and every eighth gate is constrained to the value it
+took. Each solver starts from the same domains, and the final domains are
+checked against those from sat_solve.
+
+Usage: bench-parallel-levels [gate count] [max threads]
+*/
+
+
+//! Returns the current time in seconds.
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+//! Evaluate a gate.
+static t_sat_bool eval(sat_binary_op op, t_sat_bool l, t_sat_bool r) {
+    switch(op) {
+        case(SAT_OR  ): return l | r;
+        case(SAT_NOR ): return !(l | r);
+        case(SAT_AND ): return l & r;
+        case(SAT_NAND): return !(l & r);
+        case(SAT_XOR ): return l ^ r;
+        default      : return !(l ^ r);
+    }
+}
+
+
+//! Build the benchmark netlist. The same seed always gives the same matrix.
+static sat_imp_matrix * build(unsigned int n) {
+
+    sat_imp_matrix * m      = sat_new_imp_matrix(n);
+    t_sat_bool     * value  = calloc(n, sizeof(t_sat_bool));
+    unsigned int     inputs = n / 16 + 2;
+    unsigned int     i;
+
+    srand(1);
+
+    for(i = 0; i < inputs; i += 1) {
+        value[i] = rand() & 1;
+    }
+
+    // Gates mostly read recent variables, giving a deep and wide netlist.
+    for(i = inputs; i < n; i += 1) {
+        unsigned int  window = i < 65536 ? i : 65536;
+        sat_var_idx   l      = i - 1 - rand() % window;
+        sat_var_idx   r      = i - 1 - rand() % window;
+        sat_binary_op op     = SAT_OR + rand() % 6;
+        sat_add_relation(m, i, l, op, r);
+        value[i] = eval(op, value[l], value[r]);
+    }
+
+    for(i = inputs; i < n; i += 8) {
+        sat_set_domain(m, i, value[i] == SAT_FALSE, value[i] == SAT_TRUE);
+    }
+
+    free(value);
+    return m;
+}
+
+
+int main(int argc, char ** argv) {
+
+    unsigned int n           = argc > 1 ? atoi(argv[1]) : 2000000;
+    unsigned int max_threads = argc > 2 ? atoi(argv[2]) : 0;
+
+#ifdef _OPENMP
+    if(max_threads == 0) {
+        max_threads = omp_get_num_procs();
+    }
+#else
+    max_threads = 1;
+#endif
+
+    sat_imp_matrix * reference = build(n);
+    double           t0        = now();
+    sat_solve(reference);
+    double           serial    = now() - t0;
+
+    unsigned int words = (n + SAT_DOMAINS_PER_WORD - 1) /
+                         SAT_DOMAINS_PER_WORD;
+
+    sat_imp_matrix * m = build(n);
+    sat_build_levels(m);
+    printf("Gates: %u, levels: %u\n", n, m -> level_count);
+    printf("%-22s %8.1f ms\n", "sat_solve", serial * 1e3);
+
+    t0 = now();
+    sat_solve_levelized(m);
+    printf("%-22s %8.1f ms %s\n", "sat_solve_levelized", (now() - t0) * 1e3,
+           memcmp(m -> domains, reference -> domains,
+                  words * sizeof(sat_domain_word)) ? "(mismatch!)" : "");
+    sat_free_imp_matrix(m);
+
+    unsigned int threads;
+    for(threads = 1; threads <= max_threads; threads *= 2) {
+
+        m = build(n);
+        sat_build_levels(m);
+
+        t0 = now();
+        sat_solve_parallel(m, threads);
+        double t = now() - t0;
+
+        printf("sat_solve_parallel %3u %8.1f ms  x%.2f %s\n", threads,
+               t * 1e3, serial / t,
+               memcmp(m -> domains, reference -> domains,
+                      words * sizeof(sat_domain_word)) ? "(mismatch!)" : "");
+        sat_free_imp_matrix(m);
+
+        if(threads < max_threads && threads * 2 > max_threads) {
+            threads = max_threads / 2;
+        }
+    }
+
+    sat_free_imp_matrix(reference);
+    return 0;
+}
@@ -0,0 +1,139 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "imp-matrix.h"
+
+/*!
+@file relation-layout.c
+@brief Compares revising relations stored as parallel arrays (the layout
+sat_imp_matrix used to have) against the packed sat_relation records.
+@details Both layouts share the same packed domain words, so the only
+difference measured is how a relation's operands and operation are fetched.
+Relations are visited both in index order and in a random order, the
+latter being closer to how the AC-3 worklist visits them.
+
+Usage: bench-relation-layout [relation count] [passes]
+*/
+
+//! The relation layout sat_imp_matrix used before sat_relation existed.
+typedef struct {
+    sat_var_idx   * lhs;
+    sat_var_idx   * rhs;
+    sat_binary_op * op;
+} soa_relations;
+
+
+//! Returns the current time in seconds.
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+//! Forward revision of one relation given packed operand domains.
+static inline t_sat_bool revise(
+    sat_binary_op op,
+    t_sat_bool    l,
+    t_sat_bool    r
+){
+    t_sat_bool l0 = l & 1, l1 = l >> 1, r0 = r & 1, r1 = r >> 1;
+    switch(op) {
+        case(SAT_OR  ): return (l0 && r0) | (l1 || r1) << 1;
+        case(SAT_NOR ): return (l1 || r1) | (l0 && r0) << 1;
+        case(SAT_AND ): return (l0 || r0) | (l1 && r1) << 1;
+        case(SAT_NAND): return (l1 && r1) | (l0 || r0) << 1;
+        case(SAT_XOR ): return ((l1 && r1) || (l0 && r0)) |
+                               ((l0 && r1) || (l1 && r0)) << 1;
+        default      : return ((l0 && r1) || (l1 && r0)) |
+                               ((l1 && r1) || (l0 && r0)) << 1;
+    }
+}
+
+
+int main(int argc, char ** argv) {
+
+    unsigned int n      = argc > 1 ? atoi(argv[1]) : 4000000;
+    unsigned int passes = argc > 2 ? atoi(argv[2]) : 10;
+
+    sat_imp_matrix * m = sat_new_imp_matrix(n);
+
+    soa_relations soa;
+    soa.lhs = calloc(n, sizeof(sat_var_idx));
+    soa.rhs = calloc(n, sizeof(sat_var_idx));
+    soa.op  = calloc(n, sizeof(sat_binary_op));
+
+    // A random netlist where each gate reads two earlier variables.
+    srand(1);
+    unsigned int inputs = n / 16 + 2;
+    unsigned int i;
+    for(i = inputs; i < n; i += 1) {
+        sat_var_idx   l  = rand() % i;
+        sat_var_idx   r  = rand() % i;
+        sat_binary_op op = SAT_OR + rand() % 6;
+        sat_add_relation(m, i, l, op, r);
+        soa.lhs[i] = l;
+        soa.rhs[i] = r;
+        soa.op [i] = op;
+    }
+    for(i = 0; i < inputs; i += 4) {
+        sat_set_domain(m, i, SAT_TRUE, SAT_FALSE);
+    }
+
+    // Visiting orders: sequential and shuffled.
+    sat_var_idx * order = calloc(n, sizeof(sat_var_idx));
+    for(i = 0; i < n; i += 1) order[i] = i;
+    for(i = n - 1; i > 0; i -= 1) {
+        unsigned int j = rand() % (i + 1);
+        sat_var_idx  t = order[i]; order[i] = order[j]; order[j] = t;
+    }
+
+    printf("Relations: %u, passes: %u, sizeof(sat_relation) = %lu\n",
+           n, passes, (unsigned long)sizeof(sat_relation));
+
+    int shuffled;
+    for(shuffled = 0; shuffled < 2; shuffled += 1) {
+
+        unsigned long checksum_soa = 0, checksum_aos = 0;
+        unsigned int  p;
+
+        double t0 = now();
+        for(p = 0; p < passes; p += 1) {
+            for(i = inputs; i < n; i += 1) {
+                sat_var_idx v = shuffled ? order[i] : i;
+                if(soa.op[v] == SAT_INPUT) continue;
+                checksum_soa += revise(soa.op[v],
+                                       sat_get_domain_bits(m, soa.lhs[v]),
+                                       sat_get_domain_bits(m, soa.rhs[v]));
+            }
+        }
+        double t1 = now();
+        for(p = 0; p < passes; p += 1) {
+            for(i = inputs; i < n; i += 1) {
+                sat_var_idx  v = shuffled ? order[i] : i;
+                sat_relation r = m -> relations[v];
+                if(r.op == SAT_INPUT) continue;
+                checksum_aos += revise(r.op,
+                                       sat_get_domain_bits(m, r.lhs),
+                                       sat_get_domain_bits(m, r.rhs));
+            }
+        }
+        double t2 = now();
+
+        double per = 1e9 / ((double)passes * (n - inputs));
+        printf("%-10s SoA: %6.2f ns/relation  AoS: %6.2f ns/relation %s\n",
+               shuffled ? "shuffled" : "sequential",
+               (t1 - t0) * per, (t2 - t1) * per,
+               checksum_soa == checksum_aos ? "" : "(checksum mismatch!)");
+    }
+
+    free(order);
+    free(soa.lhs);
+    free(soa.rhs);
+    free(soa.op);
+    sat_free_imp_matrix(m);
+
+    return 0;
+}
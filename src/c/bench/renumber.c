@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "imp-matrix.h"
+#include "renumber.h"
+
+/*!
+@file renumber.c
+@brief Compares sat_solve before and after sat_renumber_variables, on a
+random netlist and on a structured one whose numbering has been scrambled.
+@details The random netlist has each gate read two uniformly chosen earlier
+variables, so no numbering can keep much of it close together. The
+structured netlist is many small blocks whose gates read recent gates of
+their own block, numbered in a random order, as a parser would number a
+file whose blocks are interleaved. Both are satisfiable: a random input
+vector is simulated and every eighth gate is constrained to the value it
+took.
+
+For each numbering the benchmark prints the mean distance between an
+assignee and its operands, the solve time, and the cache misses counted by
+perf_event_open where the kernel allows it. The renumbered domains are
+restored and checked against the original solve.
+
+Usage: bench-renumber [gate count] [block size]
+*/
+
+
+//! Returns the current time in seconds.
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+//! Evaluate a gate.
+static t_sat_bool eval(sat_binary_op op, t_sat_bool l, t_sat_bool r) {
+    switch(op) {
+        case(SAT_OR  ): return l | r;
+        case(SAT_NOR ): return !(l | r);
+        case(SAT_AND ): return l & r;
+        case(SAT_NAND): return !(l & r);
+        case(SAT_XOR ): return l ^ r;
+        default      : return !(l ^ r);
+    }
+}
+
+
+/*!
+@brief Build a benchmark netlist. The same arguments always give the same
+matrix.
+@param [in] n - The number of variables.
+@param [in] block - 0 for the random netlist, otherwise the number of
+variables in each block of the structured one.
+*/
+static sat_imp_matrix * build(unsigned int n, unsigned int block) {
+
+    sat_imp_matrix * m      = sat_new_imp_matrix(n);
+    t_sat_bool     * value  = calloc(n, sizeof(t_sat_bool));
+    sat_var_idx    * index  = calloc(n, sizeof(sat_var_idx));
+    unsigned int     inputs = block ? 8 : n / 16 + 2;
+    unsigned int     i;
+
+    srand(1);
+
+    // The structured netlist is numbered in a random order.
+    for(i = 0; i < n; i += 1) {
+        index[i] = i;
+    }
+    if(block) {
+        for(i = n - 1; i > 0; i -= 1) {
+            unsigned int j = rand() % (i + 1);
+            sat_var_idx  t = index[i]; index[i] = index[j]; index[j] = t;
+        }
+    }
+
+    for(i = 0; i < n; i += 1) {
+        unsigned int  at = block ? i % block : i;
+        sat_var_idx   l, r;
+        sat_binary_op op;
+
+        if(at < inputs) {
+            value[i] = rand() & 1;
+            continue;
+        }
+
+        if(block) {
+            unsigned int window = at < 16 ? at : 16;
+            l = i - 1 - rand() % window;
+            r = i - 1 - rand() % window;
+        } else {
+            l = rand() % i;
+            r = rand() % i;
+        }
+        op = SAT_OR + rand() % 6;
+
+        sat_add_relation(m, index[i], index[l], op, index[r]);
+        value[i] = eval(op, value[l], value[r]);
+
+        if(at % 8 == 0) {
+            sat_set_domain(m, index[i], value[i] == SAT_FALSE,
+                           value[i] == SAT_TRUE);
+        }
+    }
+
+    free(value);
+    free(index);
+    return m;
+}
+
+
+//! The mean distance between the index of an assignee and its operands.
+static double mean_span(sat_imp_matrix * m) {
+
+    double       total = 0;
+    unsigned int count = 0;
+    sat_var_idx  v;
+
+    for(v = 0; v < m -> variable_count; v += 1) {
+        sat_relation * r = &m -> relations[v];
+
+        if(r -> op == SAT_INPUT) continue;
+
+        total += r -> lhs > v ? r -> lhs - v : v - r -> lhs;
+        total += r -> rhs > v ? r -> rhs - v : v - r -> rhs;
+        count += 2;
+    }
+    return count ? total / count : 0;
+}
+
+
+//! Open a counter of this process's cache misses, or return -1.
+static int open_cache_counter() {
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.size           = sizeof(attr);
+    attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+
+/*!
+@brief Solve a matrix, timing the solve and counting its cache misses.
+@details The fanout index is built first, so only propagation is measured.
+@param [inout] m - The matrix to solve.
+@param [in] counter - A counter from open_cache_counter, or -1.
+@param [out] misses - The cache misses, or -1 if they were not counted.
+@returns The solve time in seconds.
+*/
+static double timed_solve(sat_imp_matrix * m, int counter, long long * misses) {
+
+    sat_build_fanout(m);
+    *misses = -1;
+
+#ifdef __linux__
+    if(counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET , 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+
+    double t0 = now();
+    sat_solve(m);
+    double t  = now() - t0;
+
+#ifdef __linux__
+    if(counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if(read(counter, misses, sizeof(*misses)) != sizeof(*misses)) {
+            *misses = -1;
+        }
+    }
+#endif
+
+    return t;
+}
+
+
+//! Print one row of results.
+static void report(
+    const char * name,
+    double       span,
+    double       seconds,
+    long long    misses,
+    const char * note
+){
+    char counted[32] = "n/a";
+
+    if(misses >= 0) {
+        snprintf(counted, sizeof(counted), "%lld", misses);
+    }
+    printf("  %-10s span %12.1f  solve %8.1f ms  cache misses %12s %s\n",
+           name, span, seconds * 1e3, counted, note);
+}
+
+
+//! Solve one netlist in its original numbering and after renumbering.
+static void run(const char * title, unsigned int n, unsigned int block,
+                int counter) {
+
+    long long misses;
+
+    sat_imp_matrix * original = build(n, block);
+    double           span     = mean_span(original);
+    double           t        = timed_solve(original, counter, &misses);
+
+    printf("%s\n", title);
+    report("original", span, t, misses, "");
+
+    sat_imp_matrix * m = build(n, block);
+
+    double            t0    = now();
+    sat_renumbering * order = sat_renumber_variables(m);
+    double            cost  = now() - t0;
+
+    span = mean_span(m);
+    t    = timed_solve(m, counter, &misses);
+    sat_restore_numbering(order, m);
+
+    unsigned int words = (n + SAT_DOMAINS_PER_WORD - 1) /
+                         SAT_DOMAINS_PER_WORD;
+    report("renumbered", span, t, misses,
+           memcmp(m -> domains, original -> domains,
+                  words * sizeof(sat_domain_word)) ? "(mismatch!)" : "");
+    printf("  renumbering took %.1f ms\n", cost * 1e3);
+
+    sat_free_renumbering(order);
+    sat_free_imp_matrix(m);
+    sat_free_imp_matrix(original);
+}
+
+
+int main(int argc, char ** argv) {
+
+    unsigned int n       = argc > 1 ? atoi(argv[1]) : 2000000;
+    unsigned int block   = argc > 2 ? atoi(argv[2]) : 256;
+    int          counter = open_cache_counter();
+
+    printf("Variables: %u, block size: %u\n", n, block);
+
+    run("random netlist", n, 0, counter);
+    run("scrambled blocks", n, block, counter);
+
+#ifdef __linux__
+    if(counter >= 0) {
+        close(counter);
+    }
+#endif
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "collapse.h"
+
+/*!
+@brief Returns a packed domain with its two values swapped.
+*/
+static t_sat_bool sat_invert_domain(
+    t_sat_bool bits
+){
+    return ((bits & SAT_DOMAIN_0) << 1) | ((bits & SAT_DOMAIN_1) >> 1);
+}
+
+
+/*!
+@brief Check whether a relation only makes its assignee a copy or inverse
+of another variable.
+@param [in] r - The relation.
+@param [out] target - The variable the assignee is a copy or inverse of.
+@param [out] negated - Set if the assignee is the inverse of target.
+@returns SAT_TRUE if the relation is an alias.
+*/
+static t_sat_bool sat_relation_alias(
+    sat_relation  * r,
+    sat_var_idx   * target,
+    unsigned char * negated
+){
+    t_sat_bool nl = (r -> flags & SAT_RELATION_NEGATE_LHS) != 0;
+    t_sat_bool nr = (r -> flags & SAT_RELATION_NEGATE_RHS) != 0;
+
+    // SAT_EQ copies its rhs whatever the lhs is.
+    if(r -> op == SAT_EQ) {
+        *target  = r -> rhs;
+        *negated = nr;
+        return SAT_TRUE;
+    }
+
+    if(r -> lhs != r -> rhs || nl != nr) {
+        return SAT_FALSE;
+    }
+
+    // `x op x` for these operations is either x or ~x.
+    switch(r -> op) {
+        case SAT_AND :
+        case SAT_OR  : *target = r -> lhs; *negated =  nl; return SAT_TRUE;
+        case SAT_NAND:
+        case SAT_NOR : *target = r -> lhs; *negated = !nl; return SAT_TRUE;
+        default      : return SAT_FALSE;
+    }
+}
+
+
+/*!
+@brief Find the representative of a variable, compressing the path to it.
+@param [inout] collapse - The classes being built.
+@param [in] variable - The variable to look up.
+@returns The representative. collapse -> negated[variable] is then relative
+to it.
+*/
+static sat_var_idx sat_collapse_find(
+    sat_collapse * collapse,
+    sat_var_idx    variable
+){
+    sat_var_idx * parent = collapse -> representative;
+
+    // Walk to the root, adding up the parity on the way, then point every
+    // variable on the path straight at it.
+    sat_var_idx   root   = variable;
+    unsigned char parity = 0;
+
+    while(parent[root] != root) {
+        parity ^= collapse -> negated[root];
+        root    = parent[root];
+    }
+
+    sat_var_idx v = variable;
+    while(v != root) {
+        sat_var_idx   next = parent[v];
+        unsigned char own  = collapse -> negated[v];
+
+        collapse -> negated[v] = parity;
+        parent[v]              = root;
+
+        parity ^= own;
+        v       = next;
+    }
+
+    return root;
+}
+
+
+/*!
+@brief Merge every variable which is a copy or inverse of another into a
+class, and rewrite the matrix over the class representatives.
+@details Each variable has at most one relation, so following the alias
+relations from their assignees gives a forest. The representative of a
+class is the root of its tree, which is the only member whose relation is
+not an alias. An alias which would close a cycle is dropped if it agrees
+with the tree, and otherwise becomes `rep = ~rep`, which has no support.
+@param [inout] imp_mat - The matrix to rewrite.
+@returns The classes, to be freed with sat_free_collapse.
+*/
+sat_collapse * sat_collapse_equivalences(
+    sat_imp_matrix * imp_mat
+){
+    assert(imp_mat != NULL);
+
+    unsigned int   n        = imp_mat -> variable_count;
+    sat_collapse * collapse = calloc(1, sizeof(sat_collapse));
+    sat_var_idx    v;
+
+    collapse -> variable_count = n;
+    collapse -> representative = calloc(n > 0 ? n : 1, sizeof(sat_var_idx));
+    collapse -> negated        = calloc(n > 0 ? n : 1, 1);
+
+    for(v = 0; v < n; v += 1) {
+        collapse -> representative[v] = v;
+    }
+
+    // Hang each aliased assignee below the variable it aliases.
+    for(v = 0; v < n; v += 1) {
+        sat_relation * r = &imp_mat -> relations[v];
+        sat_var_idx    target;
+        unsigned char  negated;
+
+        if(!sat_relation_alias(r, &target, &negated)) {
+            continue;
+        }
+
+        sat_var_idx root = sat_collapse_find(collapse, target);
+        negated ^= collapse -> negated[target];
+
+        if(root != v) {
+            collapse -> representative[v] = root;
+            collapse -> negated[v]        = negated;
+            collapse -> collapsed        += 1;
+            sat_set_as_input(imp_mat, v);
+        } else if(negated) {
+            sat_add_relation(imp_mat, v, v, SAT_EQ, v);
+            imp_mat -> relations[v].flags = SAT_RELATION_NEGATE_RHS;
+        } else {
+            sat_set_as_input(imp_mat, v);
+        }
+    }
+
+    for(v = 0; v < n; v += 1) {
+        sat_collapse_find(collapse, v);
+    }
+
+    // Move unary constraints onto the representatives. Every member is
+    // now an input which nothing reads.
+    for(v = 0; v < n; v += 1) {
+        sat_var_idx rep = collapse -> representative[v];
+
+        if(rep == v) continue;
+
+        t_sat_bool bits = sat_get_domain_bits(imp_mat, v);
+        if(collapse -> negated[v]) {
+            bits = sat_invert_domain(bits);
+        }
+
+        sat_set_domain_bits(imp_mat, rep,
+                            sat_get_domain_bits(imp_mat, rep) & bits);
+        sat_set_domain_bits(imp_mat, v, SAT_DOMAIN_ALL);
+    }
+
+    // Point the remaining relations at the representatives.
+    for(v = 0; v < n; v += 1) {
+        sat_relation * r = &imp_mat -> relations[v];
+
+        if(r -> op == SAT_INPUT) continue;
+
+        sat_var_idx lhs = r -> lhs;
+        sat_var_idx rhs = r -> rhs;
+
+        r -> lhs    = collapse -> representative[lhs];
+        r -> rhs    = collapse -> representative[rhs];
+        if(collapse -> negated[lhs]) r -> flags ^= SAT_RELATION_NEGATE_LHS;
+        if(collapse -> negated[rhs]) r -> flags ^= SAT_RELATION_NEGATE_RHS;
+    }
+
+    imp_mat -> fanout_stale = SAT_TRUE;
+    imp_mat -> levels_stale = SAT_TRUE;
+
+    return collapse;
+}
+
+
+/*!
+@brief Copy the domain of every representative to the members of its
+class.
+@param [in] collapse - The classes of the matrix.
+@param [inout] imp_mat - The matrix passed to sat_collapse_equivalences.
+*/
+void sat_expand_equivalences(
+    sat_collapse   * collapse,
+    sat_imp_matrix * imp_mat
+){
+    assert(collapse -> variable_count <= imp_mat -> variable_count);
+
+    sat_var_idx v;
+    for(v = 0; v < collapse -> variable_count; v += 1) {
+        sat_var_idx rep = collapse -> representative[v];
+
+        if(rep == v) continue;
+
+        t_sat_bool bits = sat_get_domain_bits(imp_mat, rep);
+        sat_set_domain_bits(imp_mat, v, collapse -> negated[v] ?
+                                        sat_invert_domain(bits) : bits);
+    }
+}
+
+
+/*!
+@brief Free the classes found by sat_collapse_equivalences.
+@param [in] tofree - The classes to free.
+*/
+void sat_free_collapse(
+    sat_collapse * tofree
+){
+    free(tofree -> representative);
+    free(tofree -> negated);
+    free(tofree);
+}
@@ -0,0 +1,82 @@
+#include "imp-matrix.h"
+
+#ifndef H_COLLAPSE
+#define H_COLLAPSE
+
+/*!
+@defgroup gr-collapse Equivalence Collapsing
+
+@brief Merge variables which are copies or inverses of each other before
+solving.
+
+@details Lowering assignments leaves many relations which only alias one
+variable to another: the SAT_EQ relation joining an assignee to the result
+of its expression, and `x NAND x` for every `~x`. Chains of these add
+variables to every propagation path without constraining anything.
+
+sat_collapse_equivalences puts every variable into a class with the
+variables it is a copy or inverse of, and rewrites the remaining relations
+to read one representative per class, using the SAT_RELATION_NEGATE_*
+flags where an operand is the inverse of its representative. The other
+members of each class are left as unconstrained inputs which nothing
+reads, so they cost the solver nothing. sat_expand_equivalences copies the
+solved domain of each representative back to the members of its class, so
+the names and expectations of every variable can be checked as usual.
+
+@addtogroup gr-collapse
+@{
+*/
+
+/*!
+@brief The classes found by sat_collapse_equivalences.
+*/
+typedef struct sat_collapse_t {
+    unsigned int    variable_count; //!< Variables in the matrix collapsed.
+    sat_var_idx   * representative; //!< Representative of each variable.
+    unsigned char * negated;        //!< Set if a variable is the inverse
+                                    //!< of its representative.
+    unsigned int    collapsed;      //!< Variables merged into another.
+} sat_collapse;
+
+
+/*!
+@brief Merge every variable which is a copy or inverse of another into a
+class, and rewrite the matrix over the class representatives.
+@details Must be called before solving. Unary constraints on the members of
+a class are moved onto its representative. A class which would have to be
+its own inverse keeps a relation which cannot be satisfied, so the solver
+still reports the conflict.
+@param [inout] imp_mat - The matrix to rewrite. No relations may be added to
+it afterwards.
+@returns The classes, to be freed with sat_free_collapse.
+*/
+sat_collapse * sat_collapse_equivalences(
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Copy the domain of every representative to the members of its
+class.
+@details Call after each solve, or after sat_search, before reading the
+domains of the matrix.
+@param [in] collapse - The classes of the matrix.
+@param [inout] imp_mat - The matrix passed to sat_collapse_equivalences.
+*/
+void sat_expand_equivalences(
+    sat_collapse   * collapse,
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Free the classes found by sat_collapse_equivalences.
+@param [in] tofree - The classes to free.
+*/
+void sat_free_collapse(
+    sat_collapse * tofree
+);
+
+/*! @} */
+
+#endif
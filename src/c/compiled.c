@@ -0,0 +1,330 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "compiled.h"
+#include "sat-expression.h"
+
+//! Round an offset up to the next section boundary.
+#define SAT_COMPILED_ROUND(x) (((x) + SAT_COMPILED_ALIGN - 1) & \
+                               ~(unsigned long long)(SAT_COMPILED_ALIGN - 1))
+
+/*!
+@brief Write a section of a compiled file at its offset, padding the file
+up to it first.
+@param [inout] output - The file being written.
+@param [inout] written - How many bytes have been written so far.
+@param [in] offset - Where the section starts.
+@param [in] data - The section.
+@param [in] size - Size of the section in bytes.
+@returns SAT_TRUE on success.
+*/
+static t_sat_bool sat_write_section(
+    FILE               * output,
+    unsigned long long * written,
+    unsigned long long   offset,
+    const void         * data,
+    size_t               size
+){
+    static const char zeros[SAT_COMPILED_ALIGN] = {0};
+
+    assert(offset >= *written && offset - *written < SAT_COMPILED_ALIGN);
+
+    size_t padding = offset - *written;
+    if(fwrite(zeros, 1, padding, output) != padding ||
+       fwrite(data, 1, size, output) != size) {
+        return SAT_FALSE;
+    }
+
+    *written = offset + size;
+    return SAT_TRUE;
+}
+
+
+/*!
+@brief Write the problem held in a context to a compiled file.
+@param [inout] ctx - The context to write.
+@param [in] path - The file to write.
+@returns 0 on success, or 1 if the file could not be written.
+*/
+int sat_write_compiled(
+    sat_context * ctx,
+    const char  * path
+){
+    sat_imp_matrix * imp_mat = sat_get_imp_matrix(ctx);
+    unsigned int     n       = sat_get_variable_count(ctx);
+    sat_var_idx      vi;
+
+    assert(imp_mat -> variable_count == n);
+
+    if(imp_mat -> fanout_stale) {
+        sat_build_fanout(imp_mat);
+    }
+
+    // Gather the names and expectations into flat arrays.
+    unsigned int  * name_offsets = calloc(n > 0 ? n : 1,
+                                          sizeof(unsigned int));
+    unsigned char * expectations = calloc(n > 0 ? n : 1, 1);
+    size_t          names_size   = 0;
+
+    for(vi = 0; vi < n; vi ++) {
+        const char * name = sat_get_variable_name(ctx, vi);
+        name_offsets[vi]  = names_size;
+        names_size       += strlen(name ? name : "") + 1;
+    }
+
+    char * names = malloc(names_size > 0 ? names_size : 1);
+
+    for(vi = 0; vi < n; vi ++) {
+        const char              * name = sat_get_variable_name(ctx, vi);
+        sat_expression_variable * var  = sat_get_variable_from_id(ctx, vi);
+
+        strcpy(names + name_offsets[vi], name ? name : "");
+
+        if(ctx -> mapping != NULL) {
+            // A compiled input keeps its expectations in the mapping.
+            expectations[vi] = ctx -> mapped_expectations[vi];
+        } else if(var != NULL && var -> check_domain) {
+            expectations[vi] = SAT_COMPILED_CHECK |
+                (var -> expect_0 ? SAT_COMPILED_EXPECT_0 : 0) |
+                (var -> expect_1 ? SAT_COMPILED_EXPECT_1 : 0);
+        }
+    }
+
+    // Lay the sections out one after another.
+    sat_compiled_header header;
+    memset(&header, 0, sizeof(header));
+
+    unsigned int words = (n + SAT_DOMAINS_PER_WORD - 1) /
+                         SAT_DOMAINS_PER_WORD;
+
+    memcpy(header.magic, SAT_COMPILED_MAGIC, sizeof(header.magic));
+    header.version        = SAT_COMPILED_VERSION;
+    header.byte_order     = SAT_COMPILED_BYTE_ORDER;
+    header.variable_count = n;
+    header.fanout_count   = imp_mat -> fanout_start[n];
+    header.names_size     = names_size;
+    header.domains        = SAT_COMPILED_ROUND(sizeof(header));
+    header.relations      = SAT_COMPILED_ROUND(header.domains +
+                                words * sizeof(sat_domain_word));
+    header.fanout_start   = SAT_COMPILED_ROUND(header.relations +
+                                n * sizeof(sat_relation));
+    header.fanout         = SAT_COMPILED_ROUND(header.fanout_start +
+                                (n + 1) * sizeof(unsigned int));
+    header.name_offsets   = SAT_COMPILED_ROUND(header.fanout +
+                                header.fanout_count * sizeof(sat_var_idx));
+    header.names          = SAT_COMPILED_ROUND(header.name_offsets +
+                                n * sizeof(unsigned int));
+    header.expectations   = SAT_COMPILED_ROUND(header.names + names_size);
+    header.file_size      = header.expectations + n;
+
+    FILE             * output  = fopen(path, "wb");
+    unsigned long long written = 0;
+    t_sat_bool         ok      = output != NULL;
+
+    ok = ok && sat_write_section(output, &written, 0, &header,
+                                 sizeof(header));
+    ok = ok && sat_write_section(output, &written, header.domains,
+                                 imp_mat -> domains,
+                                 words * sizeof(sat_domain_word));
+    ok = ok && sat_write_section(output, &written, header.relations,
+                                 imp_mat -> relations,
+                                 n * sizeof(sat_relation));
+    ok = ok && sat_write_section(output, &written, header.fanout_start,
+                                 imp_mat -> fanout_start,
+                                 (n + 1) * sizeof(unsigned int));
+    ok = ok && sat_write_section(output, &written, header.fanout,
+                                 imp_mat -> fanout,
+                                 header.fanout_count * sizeof(sat_var_idx));
+    ok = ok && sat_write_section(output, &written, header.name_offsets,
+                                 name_offsets, n * sizeof(unsigned int));
+    ok = ok && sat_write_section(output, &written, header.names,
+                                 names, names_size);
+    ok = ok && sat_write_section(output, &written, header.expectations,
+                                 expectations, n);
+
+    if(output != NULL && fclose(output) != 0) {
+        ok = SAT_FALSE;
+    }
+
+    free(name_offsets);
+    free(expectations);
+    free(names);
+
+    return ok ? 0 : 1;
+}
+
+
+/*!
+@brief Check that a section lies inside a compiled file and is aligned.
+@param [in] header - The header of the file.
+@param [in] offset - Where the section starts.
+@param [in] size - Size of the section in bytes.
+@returns SAT_TRUE if the section is valid.
+*/
+static t_sat_bool sat_valid_section(
+    sat_compiled_header * header,
+    unsigned long long    offset,
+    unsigned long long    size
+){
+    return offset % SAT_COMPILED_ALIGN == 0 &&
+           offset <= header -> file_size &&
+           size   <= header -> file_size - offset;
+}
+
+
+/*!
+@brief Check that every index stored in the sections of a compiled file is
+in range, so a corrupt file cannot make the solver read outside them.
+@details Called once the sections themselves are known to be inside the
+file. Looks at every relation, fanout entry and name offset once.
+@param [in] header - The header of the file.
+@param [in] base - The start of the mapped file.
+@returns SAT_TRUE if every index is valid.
+*/
+static t_sat_bool sat_valid_contents(
+    sat_compiled_header * header,
+    const char          * base
+){
+    unsigned int         n            = header -> variable_count;
+    const sat_relation * relations    = (const sat_relation*)(base +
+                                        header -> relations);
+    const unsigned int * fanout_start = (const unsigned int*)(base +
+                                        header -> fanout_start);
+    const sat_var_idx  * fanout       = (const sat_var_idx*)(base +
+                                        header -> fanout);
+    const unsigned int * name_offsets = (const unsigned int*)(base +
+                                        header -> name_offsets);
+    unsigned int         i;
+
+    for(i = 0; i < n; i += 1) {
+        if(relations[i].op    >= SAT_OP_COUNT ||
+           relations[i].flags >= SAT_RELATION_FLAG_COUNT ||
+           relations[i].lhs   >= n ||
+           relations[i].rhs   >= n ||
+           name_offsets[i]    >= header -> names_size) {
+            return SAT_FALSE;
+        }
+    }
+
+    if(fanout_start[0] != 0) {
+        return SAT_FALSE;
+    }
+    for(i = 0; i < n; i += 1) {
+        if(fanout_start[i + 1] < fanout_start[i]) {
+            return SAT_FALSE;
+        }
+    }
+
+    for(i = 0; i < header -> fanout_count; i += 1) {
+        if(fanout[i] >= n) {
+            return SAT_FALSE;
+        }
+    }
+
+    return SAT_TRUE;
+}
+
+
+/*!
+@brief Load a compiled file into a new, empty context.
+@param [inout] ctx - A context which nothing has been parsed into yet.
+@param [in] path - The file to load.
+@returns SAT_LOAD_OK, SAT_LOAD_UNREADABLE, or SAT_LOAD_INVALID if the file
+is not a compiled file this version can read.
+*/
+int sat_load_compiled(
+    sat_context * ctx,
+    const char  * path
+){
+    assert(ctx -> mapping == NULL);
+    assert(ctx -> id_counter == 0);
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        return SAT_LOAD_UNREADABLE;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 ||
+       info.st_size < (off_t)sizeof(sat_compiled_header)) {
+        close(fd);
+        return SAT_LOAD_INVALID;
+    }
+
+    // Private, so solving writes to copies of the domain pages rather than
+    // to the file.
+    void * mapping = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(mapping == MAP_FAILED) {
+        return SAT_LOAD_UNREADABLE;
+    }
+
+    char                * base   = mapping;
+    sat_compiled_header * header = mapping;
+    unsigned int          n      = header -> variable_count;
+    unsigned long long    words  = (n + SAT_DOMAINS_PER_WORD - 1) /
+                                   SAT_DOMAINS_PER_WORD;
+
+    t_sat_bool valid =
+        memcmp(header -> magic, SAT_COMPILED_MAGIC,
+               sizeof(header -> magic)) == 0 &&
+        header -> version    == SAT_COMPILED_VERSION &&
+        header -> byte_order == SAT_COMPILED_BYTE_ORDER &&
+        header -> file_size  == (unsigned long long)info.st_size &&
+        sat_valid_section(header, header -> domains,
+                          words * sizeof(sat_domain_word)) &&
+        sat_valid_section(header, header -> relations,
+                          (unsigned long long)n * sizeof(sat_relation)) &&
+        sat_valid_section(header, header -> fanout_start,
+                          (n + 1ULL) * sizeof(unsigned int)) &&
+        sat_valid_section(header, header -> fanout,
+                          (unsigned long long)header -> fanout_count *
+                          sizeof(sat_var_idx)) &&
+        sat_valid_section(header, header -> name_offsets,
+                          (unsigned long long)n * sizeof(unsigned int)) &&
+        sat_valid_section(header, header -> names, header -> names_size) &&
+        sat_valid_section(header, header -> expectations, n);
+
+    if(valid) {
+        unsigned int * fanout_start = (unsigned int*)(base +
+                                                      header -> fanout_start);
+        valid = fanout_start[n] == header -> fanout_count &&
+                (header -> names_size == 0 ||
+                 base[header -> names + header -> names_size - 1] == '\0') &&
+                sat_valid_contents(header, base);
+    }
+
+    if(!valid) {
+        munmap(mapping, info.st_size);
+        return SAT_LOAD_INVALID;
+    }
+
+    sat_free_imp_matrix(ctx -> imp_matrix);
+
+    ctx -> imp_matrix = sat_new_borrowed_imp_matrix(n,
+        (sat_domain_word*)(base + header -> domains),
+        (sat_relation   *)(base + header -> relations),
+        (unsigned int   *)(base + header -> fanout_start),
+        (sat_var_idx    *)(base + header -> fanout));
+
+    ctx -> id_counter          = n;
+    ctx -> mapping             = mapping;
+    ctx -> mapping_size        = info.st_size;
+    ctx -> mapped_name_offsets = (unsigned int *)(base + header ->
+                                                  name_offsets);
+    ctx -> mapped_names        = base + header -> names;
+    ctx -> mapped_expectations = (unsigned char*)(base + header ->
+                                                  expectations);
+
+    return SAT_LOAD_OK;
+}
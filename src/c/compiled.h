@@ -0,0 +1,100 @@
+
+#include "sats.h"
+
+#ifndef H_COMPILED
+#define H_COMPILED
+
+/*!
+@defgroup gr-compiled Compiled Problems
+
+@brief Save a parsed problem in a binary form which can be solved without
+parsing it again.
+
+@details A compiled file holds everything a context needs, laid out exactly
+as it is in memory: the packed initial domains, the relations, the fanout
+index, the variable names and the expectations. Loading one maps the file
+copy-on-write and points the matrix straight at it, so no time is spent
+parsing, allocating or building indexes. Solving only touches the pages it
+writes to.
+
+Every section starts on a SAT_COMPILED_ALIGN byte boundary. The file is in
+the byte order of the machine which wrote it, and is rejected by machines
+with a different byte order or by a different version of the format.
+
+@addtogroup gr-compiled
+@{
+*/
+
+//! The first four bytes of every compiled file.
+#define SAT_COMPILED_MAGIC      "SATB"
+
+//! Bumped whenever the layout of a compiled file changes.
+#define SAT_COMPILED_VERSION    1
+
+//! Written as a word, so readers can tell if the byte order differs.
+#define SAT_COMPILED_BYTE_ORDER 0x01020304
+
+//! Alignment of every section of a compiled file.
+#define SAT_COMPILED_ALIGN      64
+
+//! Expectation flag: the variable's domain is checked.
+#define SAT_COMPILED_CHECK      0x1
+//! Expectation flag: the domain is expected to contain 0.
+#define SAT_COMPILED_EXPECT_0   0x2
+//! Expectation flag: the domain is expected to contain 1.
+#define SAT_COMPILED_EXPECT_1   0x4
+
+/*!
+@brief The header at the very start of a compiled file.
+@details Offsets are in bytes from the start of the file.
+*/
+typedef struct sat_compiled_header_t {
+    char               magic[4];       //!< SAT_COMPILED_MAGIC.
+    unsigned int       version;        //!< SAT_COMPILED_VERSION.
+    unsigned int       byte_order;     //!< SAT_COMPILED_BYTE_ORDER.
+    unsigned int       variable_count; //!< Number of variables.
+    unsigned int       fanout_count;   //!< Entries in the fanout index.
+    unsigned int       names_size;     //!< Bytes of null terminated names.
+    unsigned long long file_size;      //!< Size of the whole file.
+    unsigned long long domains;        //!< Offset of the packed domains.
+    unsigned long long relations;      //!< Offset of the relations.
+    unsigned long long fanout_start;   //!< Offset of the fanout offsets.
+    unsigned long long fanout;         //!< Offset of the fanout index.
+    unsigned long long name_offsets;   //!< Offset of each name, by variable.
+    unsigned long long names;          //!< Offset of the names.
+    unsigned long long expectations;   //!< Offset of the expectation flags.
+} sat_compiled_header;
+
+
+/*!
+@brief Write the problem held in a context to a compiled file.
+@details The domains written are the ones the matrix has now, so this
+should be called after parsing and before solving.
+@param [inout] ctx - The context to write. Its fanout index is built if it
+is stale.
+@param [in] path - The file to write.
+@returns 0 on success, or 1 if the file could not be written.
+*/
+int sat_write_compiled(
+    sat_context * ctx,
+    const char  * path
+);
+
+
+/*!
+@brief Load a compiled file into a new, empty context.
+@details The file is mapped for as long as the context exists. Nothing more
+may be parsed into the context.
+@param [inout] ctx - A context which nothing has been parsed into yet.
+@param [in] path - The file to load.
+@returns SAT_LOAD_OK, SAT_LOAD_UNREADABLE, or SAT_LOAD_INVALID if the file
+is not a compiled file this version can read.
+*/
+int sat_load_compiled(
+    sat_context * ctx,
+    const char  * path
+);
+
+/*! @} */
+
+#endif
@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "components.h"
+
+/*!
+@brief Find the root of a variable's tree, halving the path to it.
+@param [inout] parent - The parent of each variable.
+@param [in] variable - The variable to look up.
+@returns The root.
+*/
+static sat_var_idx sat_components_find(
+    sat_var_idx * parent,
+    sat_var_idx   variable
+){
+    while(parent[variable] != variable) {
+        parent[variable] = parent[parent[variable]];
+        variable         = parent[variable];
+    }
+    return variable;
+}
+
+
+/*!
+@brief Put two variables in the same tree.
+@details The lower root becomes the parent, so every root is the lowest
+variable of its tree.
+*/
+static void sat_components_join(
+    sat_var_idx * parent,
+    sat_var_idx   a,
+    sat_var_idx   b
+){
+    a = sat_components_find(parent, a);
+    b = sat_components_find(parent, b);
+
+    if(a < b) {
+        parent[b] = a;
+    } else if(b < a) {
+        parent[a] = b;
+    }
+}
+
+
+/*!
+@brief Find the connected components of a matrix.
+@details Joins the participants of every relation with union-find, then
+groups the variables by component with a counting sort.
+@param [in] imp_mat - The matrix to split.
+@returns The components, to be freed with sat_free_components.
+*/
+sat_components * sat_find_components(
+    sat_imp_matrix * imp_mat
+){
+    assert(imp_mat != NULL);
+
+    unsigned int     n      = imp_mat -> variable_count;
+    sat_components * result = calloc(1, sizeof(sat_components));
+    sat_var_idx    * parent = calloc(n > 0 ? n : 1, sizeof(sat_var_idx));
+    sat_var_idx      v;
+    unsigned int     c;
+
+    for(v = 0; v < n; v += 1) {
+        parent[v] = v;
+    }
+
+    for(v = 0; v < n; v += 1) {
+        sat_relation * r = &imp_mat -> relations[v];
+
+        if(r -> op != SAT_INPUT) {
+            sat_components_join(parent, v, r -> lhs);
+            sat_components_join(parent, v, r -> rhs);
+        }
+    }
+
+    result -> variable_count = n;
+    result -> local          = calloc(n > 0 ? n : 1, sizeof(unsigned int));
+    result -> members        = calloc(n > 0 ? n : 1, sizeof(sat_var_idx));
+
+    // local holds the component of each variable until the members are
+    // placed. A root is the lowest variable of its component, so it is
+    // always labelled before the rest of it.
+    unsigned int * label = result -> local;
+
+    for(v = 0; v < n; v += 1) {
+        sat_var_idx root = sat_components_find(parent, v);
+
+        if(root == v) {
+            label[v] = result -> component_count ++;
+        } else {
+            label[v] = label[root];
+        }
+    }
+
+    result -> start = calloc(result -> component_count + 1,
+                             sizeof(unsigned int));
+
+    for(v = 0; v < n; v += 1) {
+        result -> start[label[v] + 1] += 1;
+    }
+
+    for(c = 0; c < result -> component_count; c += 1) {
+        unsigned int size = result -> start[c + 1];
+
+        if(size > result -> largest) {
+            result -> largest = size;
+        }
+        result -> start[c + 1] += result -> start[c];
+    }
+
+    // parent is no longer needed, so it counts how far each component has
+    // been filled.
+    for(c = 0; c < result -> component_count; c += 1) {
+        parent[c] = result -> start[c];
+    }
+
+    for(v = 0; v < n; v += 1) {
+        c = label[v];
+
+        result -> local[v]              = parent[c] - result -> start[c];
+        result -> members[parent[c] ++] = v;
+    }
+
+    free(parent);
+
+    return result;
+}
+
+
+/*!
+@brief Copy one component into a matrix of its own, solve it, and narrow
+the original domains to the result.
+@details Domains of the original matrix are read and narrowed atomically,
+since other components may share their words.
+@param [inout] imp_mat - The matrix being solved.
+@param [in] components - The components of the matrix.
+@param [in] c - The component to solve.
+@param [in] abort - Set once any component has a conflict.
+@returns True if the component is solvable, and was not stopped early.
+*/
+static t_sat_bool sat_solve_component(
+    sat_imp_matrix   * imp_mat,
+    sat_components   * components,
+    unsigned int       c,
+    const t_sat_bool * abort
+){
+    unsigned int        first   = components -> start[c];
+    unsigned int        size    = components -> start[c + 1] - first;
+    const sat_var_idx * members = components -> members + first;
+    sat_imp_matrix    * sub     = sat_new_imp_matrix(size);
+    unsigned int        i;
+
+    for(i = 0; i < size; i += 1) {
+        sat_relation r = imp_mat -> relations[members[i]];
+
+        if(r.op != SAT_INPUT) {
+            r.lhs = components -> local[r.lhs];
+            r.rhs = components -> local[r.rhs];
+            sub -> relations[i] = r;
+        }
+        sat_set_domain_bits(sub, i, sat_load_domain_bits(imp_mat,
+                                                         members[i]));
+    }
+
+    t_sat_bool solvable = sat_solve_until(sub, abort);
+
+    // Most domains are not narrowed at all, and an atomic AND costs far
+    // more than a load.
+    for(i = 0; i < size; i += 1) {
+        t_sat_bool bits = sat_get_domain_bits(sub, i);
+
+        if(bits != sat_load_domain_bits(imp_mat, members[i])) {
+            sat_narrow_domain_bits(imp_mat, members[i], bits);
+        }
+    }
+
+    sat_free_imp_matrix(sub);
+
+    return solvable;
+}
+
+
+/*!
+@brief A component waiting to be solved, with its size, for sorting.
+*/
+typedef struct sat_component_job_t {
+    unsigned int size;      //!< Variables in the component.
+    unsigned int component; //!< The component.
+} sat_component_job;
+
+
+//! qsort comparison function putting the largest components first.
+static int sat_compare_component_jobs(const void * a, const void * b)
+{
+    const sat_component_job * ja = a;
+    const sat_component_job * jb = b;
+
+    if(ja -> size != jb -> size) {
+        return ja -> size > jb -> size ? -1 : 1;
+    }
+    return ja -> component < jb -> component ? -1 : 1;
+}
+
+
+/*!
+@brief Solve every component of a matrix in parallel.
+@details Components are handed out one at a time, largest first, so one
+large component does not start last and hold up the rest. A matrix which
+is a single component is solved in place, without copying.
+@param [inout] imp_mat - The matrix to solve.
+@param [in] components - The components of the matrix.
+@param [in] threads - How many threads to use, or 0 for the OpenMP default.
+@returns True if the system is solvable.
+*/
+t_sat_bool sat_solve_components(
+    sat_imp_matrix * imp_mat,
+    sat_components * components,
+    unsigned int     threads
+){
+    assert(imp_mat != NULL);
+    assert(components != NULL);
+    assert(components -> variable_count == imp_mat -> variable_count);
+
+    if(sat_any_domain_empty(imp_mat)) {
+        return SAT_FALSE;
+    }
+
+    if(components -> component_count <= 1) {
+        return sat_solve(imp_mat);
+    }
+
+#ifdef _OPENMP
+    if(threads == 0) {
+        threads = omp_get_max_threads();
+    }
+#endif
+
+    // A lone input which nothing reads has nothing to revise.
+    sat_component_job * jobs  = calloc(components -> component_count,
+                                       sizeof(sat_component_job));
+    unsigned int        count = 0;
+    unsigned int        c;
+
+    for(c = 0; c < components -> component_count; c += 1) {
+        unsigned int first = components -> start[c];
+        unsigned int size  = components -> start[c + 1] - first;
+
+        if(size > 1 || imp_mat -> relations[components -> members[first]].op
+                       != SAT_INPUT) {
+            jobs[count].size      = size;
+            jobs[count].component = c;
+            count += 1;
+        }
+    }
+
+    qsort(jobs, count, sizeof(sat_component_job), sat_compare_component_jobs);
+
+    t_sat_bool conflict = SAT_FALSE;
+    int        i;
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+    for(i = 0; i < (int)count; i += 1) {
+        if(__atomic_load_n(&conflict, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        if(!sat_solve_component(imp_mat, components, jobs[i].component,
+                                &conflict)) {
+            __atomic_store_n(&conflict, SAT_TRUE, __ATOMIC_RELAXED);
+        }
+    }
+
+    free(jobs);
+
+    return !conflict;
+}
+
+
+/*!
+@brief Free the components found by sat_find_components.
+@param [in] tofree - The components to free.
+*/
+void sat_free_components(
+    sat_components * tofree
+){
+    if(tofree == NULL) {
+        return;
+    }
+
+    free(tofree -> local);
+    free(tofree -> start);
+    free(tofree -> members);
+    free(tofree);
+}
@@ -0,0 +1,87 @@
+#include "imp-matrix.h"
+
+#ifndef H_COMPONENTS
+#define H_COMPONENTS
+
+/*!
+@defgroup gr-components Connected Components
+
+@brief Split a matrix into independent sub-problems and solve them in
+parallel.
+
+@details Two variables are connected if one relation has them both as
+participants. Revising a relation only changes the domains of its own
+participants, so the domains in one connected component never depend on
+the relations of another, and each component can be solved on its own.
+
+sat_find_components labels every variable with its component.
+sat_solve_components copies each component into a small matrix of its
+own, numbered from zero in the original order of its variables, solves the
+components on several threads at once, and narrows the original domains to
+the results. The worklist of each solve then only ever holds relations of
+one component, and its domains fit in far fewer words.
+
+@addtogroup gr-components
+@{
+*/
+
+/*!
+@brief The connected components found by sat_find_components.
+@details The variables of component c are members[start[c]] ..
+members[start[c+1]-1], in increasing order. Components are numbered in
+order of their lowest variable.
+*/
+typedef struct sat_components_t {
+    unsigned int    variable_count;  //!< Variables in the matrix.
+    unsigned int    component_count; //!< Number of components.
+    unsigned int    largest;         //!< Variables in the largest component.
+    unsigned int  * local;           //!< Index of each variable within its
+                                     //!< component.
+    unsigned int  * start;           //!< Offset into members of the first
+                                     //!< variable of each component.
+    sat_var_idx   * members;         //!< Variables grouped by component.
+} sat_components;
+
+
+/*!
+@brief Find the connected components of a matrix.
+@details Must be called once all relations have been added. The components
+are not updated if the relations change afterwards.
+@param [in] imp_mat - The matrix to split.
+@returns The components, to be freed with sat_free_components.
+*/
+sat_components * sat_find_components(
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Solve every component of a matrix in parallel.
+@details Gives exactly the same domains as sat_solve when the problem has
+no conflict. As soon as one component empties a domain the others stop
+early, leaving their domains partly narrowed. Components which are a
+single input read by nothing are skipped. If built without OpenMP the
+components are solved one after another.
+@param [inout] imp_mat - The matrix to solve.
+@param [in] components - The components of the matrix.
+@param [in] threads - How many threads to use, or 0 for the OpenMP default.
+@returns True if the system is solvable.
+*/
+t_sat_bool sat_solve_components(
+    sat_imp_matrix * imp_mat,
+    sat_components * components,
+    unsigned int     threads
+);
+
+
+/*!
+@brief Free the components found by sat_find_components.
+@param [in] tofree - The components to free.
+*/
+void sat_free_components(
+    sat_components * tofree
+);
+
+/*! @} */
+
+#endif
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "cone.h"
+
+/*!
+@brief Add a variable to the cone, if it is not already in it.
+@param [inout] in_cone - One flag per variable.
+@param [inout] stack - Variables whose operands are still to be visited.
+@param [inout] depth - Number of variables on the stack.
+@param [in] variable - The variable to add.
+*/
+static void sat_cone_add(
+    unsigned char * in_cone,
+    sat_var_idx   * stack,
+    unsigned int  * depth,
+    sat_var_idx     variable
+){
+    if(!in_cone[variable]) {
+        in_cone[variable]  = SAT_TRUE;
+        stack[(*depth) ++] = variable;
+    }
+}
+
+
+/*!
+@brief Delete every relation outside the transitive fan-in of the
+constrained variables and the supplied roots.
+@details Walks backwards from every root with an explicit stack, so deep
+chains of relations cannot overflow the call stack. Each variable is pushed
+at most once.
+@param [inout] imp_mat - The matrix to prune.
+@param [in] roots - The variables whose domains must stay correct.
+@param [in] root_count - The number of roots.
+@param [out] stats - If not NULL, filled in with counters for the pass.
+*/
+void sat_prune_to_cone(
+    sat_imp_matrix    * imp_mat,
+    const sat_var_idx * roots,
+    unsigned int        root_count,
+    sat_cone_stats    * stats
+){
+    assert(imp_mat != NULL);
+    assert(roots != NULL || root_count == 0);
+
+    unsigned int    n       = imp_mat -> variable_count;
+    unsigned char * in_cone = calloc(n > 0 ? n : 1, 1);
+    sat_var_idx   * stack   = calloc(n > 0 ? n : 1, sizeof(sat_var_idx));
+    unsigned int    depth   = 0;
+    sat_cone_stats  counts  = {0, 0};
+    sat_var_idx     v;
+
+    for(v = 0; v < root_count; v += 1) {
+        assert(roots[v] < n);
+        sat_cone_add(in_cone, stack, &depth, roots[v]);
+    }
+
+    for(v = 0; v < n; v += 1) {
+        sat_relation * r = &imp_mat -> relations[v];
+
+        if(sat_get_domain_bits(imp_mat, v) != SAT_DOMAIN_ALL ||
+           (r -> op != SAT_INPUT && (r -> lhs == v || r -> rhs == v))) {
+            sat_cone_add(in_cone, stack, &depth, v);
+        }
+    }
+
+    while(depth > 0) {
+        sat_relation * r = &imp_mat -> relations[stack[-- depth]];
+
+        if(r -> op != SAT_INPUT) {
+            sat_cone_add(in_cone, stack, &depth, r -> lhs);
+            sat_cone_add(in_cone, stack, &depth, r -> rhs);
+        }
+    }
+
+    for(v = 0; v < n; v += 1) {
+        if(in_cone[v]) continue;
+
+        counts.variables += 1;
+
+        if(imp_mat -> relations[v].op != SAT_INPUT) {
+            sat_set_as_input(imp_mat, v);
+            counts.relations += 1;
+        }
+    }
+
+    free(in_cone);
+    free(stack);
+
+    if(stats != NULL) {
+        *stats = counts;
+    }
+}
@@ -0,0 +1,64 @@
+#include "imp-matrix.h"
+
+#ifndef H_CONE
+#define H_CONE
+
+/*!
+@defgroup gr-cone Cone of Influence
+
+@brief Remove the relations which cannot affect the variables a problem
+asks about before solving.
+
+@details Before solving, a relation whose participants all have both values
+is already arc consistent, unless two of its participants are the same
+variable. Narrowing therefore starts at the constrained variables and runs
+outwards from them. Going forwards, from operands to an assignee, it can
+only shrink the assignee to the values its operands can still produce. A
+relation can only narrow its operands if its assignee has lost more values
+than that, which only happens in the fan-in of a constrained variable.
+
+So the domains of the constrained and expected variables, and of every
+variable in their transitive fan-in, depend only on the relations inside
+that fan-in. A relation outside it never narrows anything inside it, and
+can never empty a domain. sat_prune_to_cone deletes all such relations.
+
+Pruned variables keep the domains they had before solving, so only the
+domains of variables in the cone are meaningful afterwards. The pruned
+relations may still contain contradictions which arc consistency cannot
+see, so a search over the pruned matrix is not a search over the problem.
+
+@addtogroup gr-cone
+@{
+*/
+
+/*!
+@brief Counters describing the work done by sat_prune_to_cone.
+*/
+typedef struct sat_cone_stats_t {
+    unsigned int variables; //!< Variables outside the cone.
+    unsigned int relations; //!< Relations deleted from the matrix.
+} sat_cone_stats;
+
+
+/*!
+@brief Delete every relation outside the transitive fan-in of the
+constrained variables and the supplied roots.
+@details Must be called before solving. Constrained variables are those
+whose domain does not hold both values, and those whose relation reads
+them.
+@param [inout] imp_mat - The matrix to prune.
+@param [in] roots - The variables whose domains must stay correct, usually
+those with expectations.
+@param [in] root_count - The number of roots.
+@param [out] stats - If not NULL, filled in with counters for the pass.
+*/
+void sat_prune_to_cone(
+    sat_imp_matrix    * imp_mat,
+    const sat_var_idx * roots,
+    unsigned int        root_count,
+    sat_cone_stats    * stats
+);
+
+/*! @} */
+
+#endif
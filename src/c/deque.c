@@ -0,0 +1,175 @@
+
+#include "deque.h"
+
+/*!
+@brief Allocate a ring buffer of the given size.
+*/
+static deque_buffer * deque_buffer_new(
+    long size
+){
+    deque_buffer * tr = calloc(1, sizeof(deque_buffer));
+    tr -> size  = size;
+    tr -> items = calloc(size, sizeof(unsigned int));
+    return tr;
+}
+
+
+/*!
+@brief Create a new empty deque.
+@param [in] size - Initial capacity, rounded up to a power of 2.
+@returns a new empty deque.
+*/
+deque * deque_new(
+    long size
+){
+    long rounded = 16;
+
+    while(rounded < size) {
+        rounded *= 2;
+    }
+
+    deque * tr = calloc(1, sizeof(deque));
+    tr -> buffer = deque_buffer_new(rounded);
+    return tr;
+}
+
+
+/*!
+@brief Free the memory allocated for a deque, and all of its old buffers.
+@param [in] tofree - The deque to free.
+*/
+void deque_free(
+    deque * tofree
+){
+    deque_buffer * walker = tofree -> buffer;
+
+    while(walker != NULL) {
+        deque_buffer * next = walker -> retired;
+        free(walker -> items);
+        free(walker);
+        walker = next;
+    }
+
+    free(tofree);
+}
+
+
+/*!
+@brief Replace the buffer of a deque with one twice the size.
+@details Thieves which loaded the old buffer may still read from it, so it
+is kept on the retired list rather than being freed.
+*/
+static deque_buffer * deque_grow(
+    deque        * d,
+    deque_buffer * old,
+    long           top,
+    long           bottom
+){
+    deque_buffer * tr = deque_buffer_new(old -> size * 2);
+    long           i;
+
+    for(i = top; i < bottom; i += 1) {
+        tr -> items[i & (tr -> size - 1)] =
+            __atomic_load_n(&old -> items[i & (old -> size - 1)],
+                            __ATOMIC_RELAXED);
+    }
+
+    tr -> retired = old;
+    __atomic_store_n(&d -> buffer, tr, __ATOMIC_RELEASE);
+    return tr;
+}
+
+
+/*!
+@brief Add an index to the bottom of the deque.
+@warning Must only be called by the thread which owns the deque.
+@param [in] d - The deque to append to.
+@param [in] toadd - The index to add.
+*/
+void deque_push(
+    deque        * d,
+    unsigned int   toadd
+){
+    long           b   = __atomic_load_n(&d -> bottom, __ATOMIC_RELAXED);
+    long           t   = __atomic_load_n(&d -> top,    __ATOMIC_ACQUIRE);
+    deque_buffer * buf = __atomic_load_n(&d -> buffer, __ATOMIC_RELAXED);
+
+    if(b - t > buf -> size - 1) {
+        buf = deque_grow(d, buf, t, b);
+    }
+
+    __atomic_store_n(&buf -> items[b & (buf -> size - 1)], toadd,
+                     __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&d -> bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+
+/*!
+@brief Remove the index most recently pushed to the deque.
+@warning Must only be called by the thread which owns the deque.
+@param [in] d - The deque to remove from.
+@returns The index, or DEQUE_EMPTY.
+*/
+unsigned int deque_take(
+    deque * d
+){
+    long           b   = __atomic_load_n(&d -> bottom, __ATOMIC_RELAXED) - 1;
+    deque_buffer * buf = __atomic_load_n(&d -> buffer, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&d -> bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    long         t  = __atomic_load_n(&d -> top, __ATOMIC_RELAXED);
+    unsigned int tr = DEQUE_EMPTY;
+
+    if(t <= b) {
+        tr = __atomic_load_n(&buf -> items[b & (buf -> size - 1)],
+                             __ATOMIC_RELAXED);
+
+        if(t == b) {
+            // Last item, so race any thieves for it.
+            if(!__atomic_compare_exchange_n(&d -> top, &t, t + 1, 0,
+                                            __ATOMIC_SEQ_CST,
+                                            __ATOMIC_RELAXED)) {
+                tr = DEQUE_EMPTY;
+            }
+            __atomic_store_n(&d -> bottom, b + 1, __ATOMIC_RELAXED);
+        }
+    } else {
+        __atomic_store_n(&d -> bottom, b + 1, __ATOMIC_RELAXED);
+    }
+
+    return tr;
+}
+
+
+/*!
+@brief Remove the index least recently pushed to the deque.
+@details May be called from any thread.
+@param [in] d - The deque to steal from.
+@returns The index, DEQUE_EMPTY, or DEQUE_ABORT if another thread took the
+same index first.
+*/
+unsigned int deque_steal(
+    deque * d
+){
+    long t = __atomic_load_n(&d -> top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long b = __atomic_load_n(&d -> bottom, __ATOMIC_ACQUIRE);
+
+    if(t >= b) {
+        return DEQUE_EMPTY;
+    }
+
+    deque_buffer * buf = __atomic_load_n(&d -> buffer, __ATOMIC_ACQUIRE);
+    unsigned int   tr  = __atomic_load_n(&buf -> items[t & (buf -> size - 1)],
+                                         __ATOMIC_RELAXED);
+
+    if(!__atomic_compare_exchange_n(&d -> top, &t, t + 1, 0,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return DEQUE_ABORT;
+    }
+
+    return tr;
+}
@@ -0,0 +1,104 @@
+#include <stdlib.h>
+
+#ifndef DEQUE_H
+#define DEQUE_H
+
+
+/*!
+@defgroup gr-deque Work Stealing Deque
+
+@brief A lock-free Chase-Lev deque of variable indexes.
+
+@details The thread which owns a deque pushes and takes indexes at the
+bottom, while any other thread may steal from the top. Only the owner ever
+changes the bottom, and thieves race for the top with a compare and swap,
+so no locks are needed. When the ring buffer fills up the owner swaps in
+one twice the size. Old buffers may still be read by a thief part way
+through a steal, so they are kept until the deque is freed.
+
+@addtogroup gr-deque
+@{
+*/
+
+//! Returned by deque_take and deque_steal when there was nothing to take.
+#define DEQUE_EMPTY 0xFFFFFFFFu
+
+//! Returned by deque_steal when it lost a race and should try again.
+#define DEQUE_ABORT 0xFFFFFFFEu
+
+/*!
+@brief One ring buffer of a deque.
+*/
+typedef struct deque_buffer_t {
+    long                    size;       //<! Capacity, always a power of 2.
+    struct deque_buffer_t * retired;    //<! Older buffer this replaced.
+    unsigned int          * items;      //<! The ring buffer itself.
+} deque_buffer;
+
+/*!
+@brief A work stealing deque.
+*/
+typedef struct deque_t {
+    long           top;         //<! Next index to steal. Written by thieves.
+    char           pad[56];     //<! Keeps top and bottom on separate lines.
+    long           bottom;      //<! Next free slot. Written by the owner.
+    deque_buffer * buffer;      //<! Current ring buffer.
+} deque;
+
+
+/*!
+@brief Create a new empty deque.
+@param [in] size - Initial capacity, rounded up to a power of 2.
+@returns a new empty deque.
+*/
+deque * deque_new(
+    long size
+);
+
+
+/*!
+@brief Free the memory allocated for a deque, and all of its old buffers.
+@param [in] tofree - The deque to free.
+*/
+void deque_free(
+    deque * tofree
+);
+
+
+/*!
+@brief Add an index to the bottom of the deque.
+@warning Must only be called by the thread which owns the deque.
+@param [in] d - The deque to append to.
+@param [in] toadd - The index to add.
+*/
+void deque_push(
+    deque        * d,
+    unsigned int   toadd
+);
+
+
+/*!
+@brief Remove the index most recently pushed to the deque.
+@warning Must only be called by the thread which owns the deque.
+@param [in] d - The deque to remove from.
+@returns The index, or DEQUE_EMPTY.
+*/
+unsigned int deque_take(
+    deque * d
+);
+
+
+/*!
+@brief Remove the index least recently pushed to the deque.
+@details May be called from any thread.
+@param [in] d - The deque to steal from.
+@returns The index, DEQUE_EMPTY, or DEQUE_ABORT if another thread took the
+same index first.
+*/
+unsigned int deque_steal(
+    deque * d
+);
+
+/*! @} */
+
+#endif
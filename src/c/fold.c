@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "fold.h"
+
+/*!
+@brief Add every relation which reads a variable to the worklist.
+*/
+static void sat_fold_enqueue_readers(
+    sat_imp_matrix * imp_mat,
+    worklist       * pending,
+    sat_var_idx      variable
+){
+    unsigned int f   = imp_mat -> fanout_start[variable    ];
+    unsigned int end = imp_mat -> fanout_start[variable + 1];
+
+    for(; f < end; f += 1) {
+        worklist_enqueue(pending, imp_mat -> fanout[f]);
+    }
+}
+
+
+/*!
+@brief Fold fixed values forwards through the relations of a matrix.
+@details Every relation starts on a worklist. When a relation is deleted,
+the relations reading its assignee are visited again, since it is now
+fixed. The fanout index is only used to find those readers, so it does not
+matter that relations turned into aliases no longer read both operands.
+@param [inout] imp_mat - The matrix to simplify.
+@param [out] stats - If not NULL, filled in with counters for the pass.
+*/
+void sat_fold_constants(
+    sat_imp_matrix * imp_mat,
+    sat_fold_stats * stats
+){
+    assert(imp_mat != NULL);
+
+    sat_fold_stats counts = {0, 0};
+
+    if(imp_mat -> fanout_stale) {
+        sat_build_fanout(imp_mat);
+    }
+
+    worklist * pending = worklist_new(imp_mat -> variable_count);
+    sat_var_idx v;
+
+    for(v = 0; v < imp_mat -> variable_count; v += 1) {
+        worklist_enqueue(pending, v);
+    }
+
+    while(pending -> length > 0) {
+
+        v = worklist_dequeue(pending);
+
+        sat_relation * r     = &imp_mat -> relations[v];
+        unsigned short truth = sat_relation_truth(r);
+
+        if(truth == SAT_OP_UNCONSTRAINED || r -> lhs == v || r -> rhs == v) {
+            continue;
+        }
+
+        t_sat_bool l_dom = sat_get_domain_bits(imp_mat, r -> lhs);
+        t_sat_bool r_dom = sat_get_domain_bits(imp_mat, r -> rhs);
+
+        if(l_dom == 0 || r_dom == 0) {
+            continue;
+        }
+
+        // Which values can the relation give, with the operands it has?
+        t_sat_bool values = 0;
+        t_sat_bool lv, rv;
+
+        for(lv = 0; lv < 2; lv += 1) {
+            for(rv = 0; rv < 2; rv += 1) {
+                if(((l_dom >> lv) & 1) && ((r_dom >> rv) & 1) &&
+                   (r -> lhs != r -> rhs || lv == rv)) {
+                    values |= 1 << ((truth >> (2 * lv + rv)) & 1);
+                }
+            }
+        }
+
+        if(values != SAT_DOMAIN_ALL) {
+
+            // Only one value, whatever the free operands turn out to be, so
+            // the relation constrains nothing but its assignee.
+            sat_set_domain_bits(imp_mat, v,
+                                sat_get_domain_bits(imp_mat, v) & values);
+            sat_set_as_input(imp_mat, v);
+            sat_fold_enqueue_readers(imp_mat, pending, v);
+            counts.folded += 1;
+
+        } else if(r -> lhs != r -> rhs &&
+                  (l_dom == SAT_DOMAIN_ALL) != (r_dom == SAT_DOMAIN_ALL)) {
+
+            // One operand is fixed and both values are possible, so the
+            // relation copies or inverts the other operand.
+            sat_var_idx free_operand;
+            t_sat_bool  when_1;
+
+            if(l_dom != SAT_DOMAIN_ALL) {
+                free_operand = r -> rhs;
+                when_1       = (truth >> (2 * (l_dom >> 1) + 1)) & 1;
+            } else {
+                free_operand = r -> lhs;
+                when_1       = (truth >> (2 + (r_dom >> 1))) & 1;
+            }
+
+            sat_add_relation(imp_mat, v, free_operand, SAT_EQ, free_operand);
+            imp_mat -> relations[v].flags = when_1 ? 0
+                                                   : SAT_RELATION_NEGATE_RHS;
+            counts.reduced += 1;
+        }
+    }
+
+    worklist_free(pending);
+
+    imp_mat -> fanout_stale = SAT_TRUE;
+    imp_mat -> levels_stale = SAT_TRUE;
+
+    if(stats != NULL) {
+        *stats = counts;
+    }
+}
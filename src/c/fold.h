@@ -0,0 +1,57 @@
+#include "imp-matrix.h"
+
+#ifndef H_FOLD
+#define H_FOLD
+
+/*!
+@defgroup gr-fold Constant Folding
+
+@brief Remove relations whose result is already known before solving.
+
+@details Constants in expressions, and variables fixed by unary
+constraints, often decide the value of the relations which read them
+outright, and through those the relations which read their results.
+sat_fold_constants sweeps these values forwards through the matrix before
+it is solved. A relation which can only give one value has that value
+moved into its assignee's domain and is deleted, turning the assignee into
+a fixed input. A relation with one fixed operand which passes the other
+straight through or inverts it, such as `b & 1` or `b ^ 1`, becomes a
+SAT_EQ alias of that operand, which sat_collapse_equivalences can then
+remove.
+
+The domains found by solving the smaller matrix are the same as for the
+original when the problem has no conflict. When it has one, the conflict is
+still reported, but may empty different domains.
+
+@addtogroup gr-fold
+@{
+*/
+
+/*!
+@brief Counters describing the work done by sat_fold_constants.
+*/
+typedef struct sat_fold_stats_t {
+    unsigned int folded;    //!< Relations deleted because their value was
+                            //!< known.
+    unsigned int reduced;   //!< Relations turned into copies or inverses
+                            //!< of one operand.
+} sat_fold_stats;
+
+
+/*!
+@brief Fold fixed values forwards through the relations of a matrix.
+@details Must be called before solving, once all relations have been
+added. The domains of deleted relations' assignees are narrowed to the
+value they were found to take. If that value was already excluded the
+domain becomes empty, and the solver reports the conflict.
+@param [inout] imp_mat - The matrix to simplify.
+@param [out] stats - If not NULL, filled in with counters for the pass.
+*/
+void sat_fold_constants(
+    sat_imp_matrix * imp_mat,
+    sat_fold_stats * stats
+);
+
+/*! @} */
+
+#endif
@@ -2,37 +2,170 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
 
 #include "imp-matrix.h"
 
 
 /*!
-@warning Asserts that variable_count > 0
+@details A matrix created with variable_count == 0 is valid, and grows as
+relations and domains are added to it.
 */
 sat_imp_matrix * sat_new_imp_matrix(
     unsigned int variable_count
 ){
-    assert(variable_count > 0);
-    
     sat_imp_matrix * to_return;
 
     to_return = calloc(1, sizeof(sat_imp_matrix));
-        
+
+    if(to_return == NULL) {
+        return NULL;
+    }
+
+    to_return -> variable_count = 0;
+    to_return -> capacity       = 0;
+
+    to_return -> fanout_start = NULL;
+    to_return -> fanout       = NULL;
+    to_return -> fanout_stale = SAT_TRUE;
+
+    to_return -> level_order    = NULL;
+    to_return -> level_start    = NULL;
+    to_return -> level_count    = 0;
+    to_return -> levels_acyclic = SAT_FALSE;
+    to_return -> levels_stale   = SAT_TRUE;
+
+    sat_resize_imp_matrix(to_return, variable_count);
+
+    return to_return;
+}
+
+
+/*!
+@details The matrix is built with an up to date fanout index, so it can be
+solved without any further set up.
+*/
+sat_imp_matrix * sat_new_borrowed_imp_matrix(
+    unsigned int      variable_count,
+    sat_domain_word * domains,
+    sat_relation    * relations,
+    unsigned int    * fanout_start,
+    sat_var_idx     * fanout
+){
+    sat_imp_matrix * to_return = sat_new_imp_matrix(0);
+
+    if(to_return == NULL) {
+        return NULL;
+    }
+
     to_return -> variable_count = variable_count;
-    
-    to_return -> domain_0 = calloc(variable_count, sizeof(t_sat_bool));
-    to_return -> domain_1 = calloc(variable_count, sizeof(t_sat_bool));
-    to_return -> lhs      = calloc(variable_count, sizeof(sat_var_idx));
-    to_return -> rhs      = calloc(variable_count, sizeof(sat_var_idx));
-    to_return -> op       = calloc(variable_count, sizeof(sat_binary_op));
+    to_return -> capacity       = variable_count;
+    to_return -> domains        = domains;
+    to_return -> relations      = relations;
+    to_return -> fanout_start   = fanout_start;
+    to_return -> fanout         = fanout;
+    to_return -> fanout_stale   = SAT_FALSE;
+    to_return -> borrowed       = SAT_TRUE;
+
+    return to_return;
+}
+
+
+/*!
+@brief Copy borrowed arrays into memory the matrix owns, so they can be
+grown or freed.
+@param [inout] imp_mat - The matrix to operate on.
+*/
+static void sat_own_imp_matrix(
+    sat_imp_matrix * imp_mat
+){
+    if(!imp_mat -> borrowed) {
+        return;
+    }
+
+    unsigned int n     = imp_mat -> variable_count;
+    unsigned int words = (imp_mat -> capacity + SAT_DOMAINS_PER_WORD - 1) /
+                         SAT_DOMAINS_PER_WORD;
+    size_t       sizes[4] = {
+        words * sizeof(sat_domain_word),
+        n * sizeof(sat_relation),
+        (n + 1) * sizeof(unsigned int),
+        imp_mat -> fanout_start[n] * sizeof(sat_var_idx)
+    };
+    void      ** arrays[4] = {
+        (void**)&imp_mat -> domains,
+        (void**)&imp_mat -> relations,
+        (void**)&imp_mat -> fanout_start,
+        (void**)&imp_mat -> fanout
+    };
+
+    unsigned int i;
+    for(i = 0; i < 4; i += 1) {
+        void * copy = malloc(sizes[i] > 0 ? sizes[i] : 1);
+        memcpy(copy, *arrays[i], sizes[i]);
+        *arrays[i] = copy;
+    }
+
+    imp_mat -> borrowed = SAT_FALSE;
+}
+
+
+/*!
+@details Storage grows geometrically, so adding variables one at a time
+costs amortised constant time.
+*/
+void sat_resize_imp_matrix(
+    sat_imp_matrix * imp_mat,
+    unsigned int     variable_count
+){
+    assert(imp_mat != NULL);
+
+    if(variable_count <= imp_mat -> variable_count) {
+        return;
+    }
+
+    if(variable_count > imp_mat -> capacity) {
 
+        sat_own_imp_matrix(imp_mat);
+
+        unsigned int capacity = imp_mat -> capacity ? imp_mat -> capacity
+                                                    : 64;
+        while(capacity < variable_count) {
+            capacity *= 2;
+        }
+
+        unsigned int old_words = (imp_mat -> capacity + SAT_DOMAINS_PER_WORD
+                                  - 1) / SAT_DOMAINS_PER_WORD;
+        unsigned int new_words = (capacity + SAT_DOMAINS_PER_WORD - 1) /
+                                 SAT_DOMAINS_PER_WORD;
+
+        imp_mat -> domains  = realloc(imp_mat -> domains,
+                                      new_words * sizeof(sat_domain_word));
+
+        // Unused domain bits are kept set, so new variables start out
+        // unconstrained and word-wide scans need no masking.
+        unsigned int w;
+        for(w = old_words; w < new_words; w += 1) {
+            imp_mat -> domains[w] = ~(sat_domain_word)0;
+        }
+
+        imp_mat -> relations = realloc(imp_mat -> relations,
+                                       capacity * sizeof(sat_relation));
+
+        imp_mat -> capacity = capacity;
+    }
+
+    // New variables are unconstrained inputs.
     unsigned int i = 0;
-    for(i = 0; i < variable_count; i +=1){
-        to_return -> domain_0[i] = SAT_TRUE;
-        to_return -> domain_1[i] = SAT_TRUE;
+    for(i = imp_mat -> variable_count; i < variable_count; i +=1){
+        sat_set_domain_bits(imp_mat, i, SAT_DOMAIN_ALL);
+        memset(&imp_mat -> relations[i], 0, sizeof(sat_relation));
+        imp_mat -> relations[i].op = SAT_INPUT;
     }
 
-    return to_return;
+    imp_mat -> variable_count = variable_count;
+    imp_mat -> fanout_stale   = SAT_TRUE;
+    imp_mat -> levels_stale   = SAT_TRUE;
 }
 
 
@@ -45,11 +178,16 @@ void sat_free_imp_matrix(
     
     assert(imp_mat != NULL);
 
-    free(imp_mat -> domain_0);
-    free(imp_mat -> domain_1);
-    free(imp_mat -> lhs     );
-    free(imp_mat -> rhs     );
-    free(imp_mat -> op      );
+    if(!imp_mat -> borrowed) {
+        free(imp_mat -> domains );
+        free(imp_mat -> relations);
+
+        free(imp_mat -> fanout_start);
+        free(imp_mat -> fanout      );
+    }
+
+    free(imp_mat -> level_order );
+    free(imp_mat -> level_start );
 
     free (imp_mat);
     return;
@@ -84,10 +222,22 @@ void sat_add_relation (
 ){
     
     //printf("Add relation %d between %d, %d, %d\n",op, assignee,lhs,rhs);
-    imp_mat -> lhs[assignee] = lhs;
-    imp_mat -> rhs[assignee] = rhs;
-    imp_mat -> op [assignee] = op;
+    assert(op < SAT_OP_COUNT);
 
+    sat_var_idx largest = assignee > lhs ? assignee : lhs;
+    largest             = largest  > rhs ? largest  : rhs;
+
+    if(largest >= imp_mat -> variable_count) {
+        sat_resize_imp_matrix(imp_mat, largest + 1);
+    }
+
+    imp_mat -> relations[assignee].lhs = lhs;
+    imp_mat -> relations[assignee].rhs = rhs;
+    imp_mat -> relations[assignee].op  = op;
+    imp_mat -> relations[assignee].flags = 0;
+
+    imp_mat -> fanout_stale  = SAT_TRUE;
+    imp_mat -> levels_stale  = SAT_TRUE;
 }
 
 
@@ -103,9 +253,13 @@ void sat_set_as_input(
     sat_var_idx      variable
 ){
     
-    imp_mat -> lhs[variable] = 0;
-    imp_mat -> rhs[variable] = 0;
-    imp_mat -> op [variable] = SAT_INPUT;
+    imp_mat -> relations[variable].lhs = 0;
+    imp_mat -> relations[variable].rhs = 0;
+    imp_mat -> relations[variable].op  = SAT_INPUT;
+    imp_mat -> relations[variable].flags = 0;
+
+    imp_mat -> fanout_stale  = SAT_TRUE;
+    imp_mat -> levels_stale  = SAT_TRUE;
 }
 
 
@@ -119,7 +273,7 @@ t_sat_bool sat_is_input(
     sat_imp_matrix * imp_mat,
     sat_var_idx      variable
 ) {
-    return imp_mat -> op[variable] == SAT_INPUT;
+    return imp_mat -> relations[variable].op == SAT_INPUT;
 }
 
 
@@ -140,8 +294,13 @@ void sat_set_domain(
     sat_var_idx      can_be_1
 ) {
 
-    imp_mat -> domain_0[variable] = can_be_0;
-    imp_mat -> domain_1[variable] = can_be_1;
+    if(variable >= imp_mat -> variable_count) {
+        sat_resize_imp_matrix(imp_mat, variable + 1);
+    }
+
+    sat_set_domain_bits(imp_mat, variable,
+                        (can_be_0 ? SAT_DOMAIN_0 : 0) |
+                        (can_be_1 ? SAT_DOMAIN_1 : 0));
 }
 
 
@@ -156,8 +315,8 @@ t_sat_bool sat_value_in_domain(
     sat_var_idx      variable,
     t_sat_bool       value
 ) {
-    return value ? imp_mat -> domain_1[variable] :
-                   imp_mat -> domain_0[variable] ;
+    t_sat_bool bits = sat_get_domain_bits(imp_mat, variable);
+    return value ? (bits >> 1) : (bits & SAT_DOMAIN_0);
 }
 
 
@@ -171,89 +330,433 @@ t_sat_bool sat_domain_empty(
     sat_imp_matrix * imp_mat,
     sat_var_idx      variable
 ){
-    return !(imp_mat -> domain_1[variable] ||
-             imp_mat -> domain_0[variable]  );
+    return sat_get_domain_bits(imp_mat, variable) == 0;
+}
 
+
+/*!
+@brief Returns the number of sat_domain_words holding real variables.
+*/
+static unsigned int sat_domain_word_count(
+    sat_imp_matrix * imp_mat
+){
+    return (imp_mat -> variable_count + SAT_DOMAINS_PER_WORD - 1) /
+           SAT_DOMAINS_PER_WORD;
 }
 
 
 /*!
-@brief Checks a single relation is satisfiable.
+@brief Count the variables whose domain does not include a value.
+@param [in] imp_mat - The matrix to operate on.
+@param [in] value - The value to look for.
+@returns The number of variables which cannot take the value.
+*/
+unsigned int sat_count_excluded(
+    sat_imp_matrix * imp_mat,
+    t_sat_bool       value
+){
+    unsigned int words = sat_domain_word_count(imp_mat);
+    unsigned int count = 0;
+    unsigned int shift = value ? 1 : 0;
+    unsigned int w;
+
+    for(w = 0; w < words; w += 1) {
+        sat_domain_word missing = ~(imp_mat -> domains[w] >> shift) &
+                                  SAT_DOMAIN_LOW_BITS;
+        count += __builtin_popcountll(missing);
+    }
+
+    return count;
+}
+
+
+/*!
+@brief Count the variables whose domain is empty.
+@param [in] imp_mat - The matrix to operate on.
+@returns The number of variables with an empty domain.
+*/
+unsigned int sat_count_empty_domains(
+    sat_imp_matrix * imp_mat
+){
+    unsigned int words = sat_domain_word_count(imp_mat);
+    unsigned int count = 0;
+    unsigned int w;
+
+    for(w = 0; w < words; w += 1) {
+        sat_domain_word d     = imp_mat -> domains[w];
+        sat_domain_word empty = ~(d | (d >> 1)) & SAT_DOMAIN_LOW_BITS;
+        count += __builtin_popcountll(empty);
+    }
+
+    return count;
+}
+
+
+/*!
+@brief Check whether any variable has an empty domain.
+@param [in] imp_mat - The matrix to operate on.
+@returns SAT_TRUE if some variable has an empty domain.
+*/
+t_sat_bool sat_any_domain_empty(
+    sat_imp_matrix * imp_mat
+){
+    unsigned int words = sat_domain_word_count(imp_mat);
+    unsigned int w;
+
+    for(w = 0; w < words; w += 1) {
+        sat_domain_word d = imp_mat -> domains[w];
+        if(~(d | (d >> 1)) & SAT_DOMAIN_LOW_BITS) {
+            return SAT_TRUE;
+        }
+    }
+
+    return SAT_FALSE;
+}
+
+
+/*!
+@brief Truth table of every operation.
+@details Bit (2*l + r) of an entry is the value the assignee takes when the
+lhs is l and the rhs is r. Operations which constrain nothing (inputs) have
+the entry SAT_OP_UNCONSTRAINED. New operations only need an entry here.
+*/
+static const unsigned short sat_op_truth[SAT_OP_COUNT] = {
+    [SAT_INPUT] = SAT_OP_UNCONSTRAINED,
+    [SAT_OR   ] = 0xE,
+    [SAT_NOR  ] = 0x1,
+    [SAT_XOR  ] = 0x6,
+    [SAT_NXOR ] = 0x9,
+    [SAT_AND  ] = 0x8,
+    [SAT_NAND ] = 0x7,
+    [SAT_EQ   ] = 0xA,
+    [SAT_IMP  ] = 0xB,
+    [SAT_NOT  ] = SAT_OP_UNCONSTRAINED,
+    [SAT_NOP  ] = SAT_OP_UNCONSTRAINED
+};
+
+
+/*!
+@brief Returns the truth table of a relation, with any negated operands
+taken into account.
+@param [in] r - The relation.
+@returns SAT_OP_UNCONSTRAINED or a table indexed as sat_op_truth is.
+*/
+unsigned short sat_relation_truth(
+    sat_relation * r
+){
+    unsigned short truth = sat_op_truth[r -> op];
+
+    if(truth == SAT_OP_UNCONSTRAINED) {
+        return truth;
+    }
+
+    t_sat_bool     nl = (r -> flags & SAT_RELATION_NEGATE_LHS) != 0;
+    t_sat_bool     nr = (r -> flags & SAT_RELATION_NEGATE_RHS) != 0;
+    unsigned short tr = 0;
+    t_sat_bool     lv, rv;
+
+    for(lv = 0; lv < 2; lv += 1) {
+        for(rv = 0; rv < 2; rv += 1) {
+            tr |= ((truth >> (2 * (lv ^ nl) + (rv ^ nr))) & 1) <<
+                  (2 * lv + rv);
+        }
+    }
+
+    return tr;
+}
+
+
+/*!
+@brief Revised domains for every opcode, operand negation, lhs/rhs aliasing
+and combination of assignee, lhs and rhs domains.
+@details Indexed as [op][flags][lhs == rhs][assignee][lhs][rhs] using packed
+domains. Each entry holds the new assignee domain in bits 0-1, the new lhs
+domain in bits 2-3 and the new rhs domain in bits 4-5. Filled in by
+sat_build_revise_table before main runs.
+*/
+static unsigned char sat_revise_table[SAT_OP_COUNT]
+                                      [SAT_RELATION_FLAG_COUNT][2][4][4][4];
+
+
+/*!
+@brief Revises the domains of the three participants of a relation.
+@details Removes from each domain every value which has no support: a
+combination of values from the other two domains which satisfies the
+relation. Where two participants are the same variable (eg. NOT is
+expressed as `x NAND x`) only combinations which give that variable the
+same value are considered.
+@param [in] op - The operation of the relation.
+@param [in] flags - SAT_RELATION_NEGATE_* flags of the relation.
+@param [in] alias_lr - Are the lhs and rhs the same variable?
+@param [in] alias_al - Are the assignee and lhs the same variable?
+@param [in] alias_ar - Are the assignee and rhs the same variable?
+@param [in] a_dom - Packed domain of the assignee.
+@param [in] l_dom - Packed domain of the lhs.
+@param [in] r_dom - Packed domain of the rhs.
+@returns The new domains, packed as in sat_revise_table.
+*/
+static unsigned char sat_revise_supports(
+    sat_binary_op op,
+    unsigned char flags,
+    t_sat_bool    alias_lr,
+    t_sat_bool    alias_al,
+    t_sat_bool    alias_ar,
+    t_sat_bool    a_dom,
+    t_sat_bool    l_dom,
+    t_sat_bool    r_dom
+){
+    unsigned short truth = sat_op_truth[op];
+
+    if(truth == SAT_OP_UNCONSTRAINED) {
+        return a_dom | l_dom << 2 | r_dom << 4;
+    }
+
+    t_sat_bool a_sup = 0;
+    t_sat_bool l_sup = 0;
+    t_sat_bool r_sup = 0;
+
+    t_sat_bool nl = (flags & SAT_RELATION_NEGATE_LHS) != 0;
+    t_sat_bool nr = (flags & SAT_RELATION_NEGATE_RHS) != 0;
+
+    t_sat_bool lv, rv;
+    for(lv = 0; lv < 2; lv += 1) {
+        for(rv = 0; rv < 2; rv += 1) {
+
+            t_sat_bool av = (truth >> (2 * (lv ^ nl) + (rv ^ nr))) & 1;
+
+            if(!((l_dom >> lv) & 1) || !((r_dom >> rv) & 1)) continue;
+            if(!((a_dom >> av) & 1))                          continue;
+            if(alias_lr && lv != rv)                          continue;
+            if(alias_al && av != lv)                          continue;
+            if(alias_ar && av != rv)                          continue;
+
+            a_sup |= 1 << av;
+            l_sup |= 1 << lv;
+            r_sup |= 1 << rv;
+        }
+    }
+
+    return a_sup | l_sup << 2 | r_sup << 4;
+}
+
+
+/*!
+@brief Fill in sat_revise_table from sat_op_truth.
+@details Runs automatically before main, so the table is ready before any
+thread can use it.
+*/
+__attribute__((constructor))
+static void sat_build_revise_table()
+{
+    unsigned int op, flags, alias, a, l, r;
+
+    for(op = 0; op < SAT_OP_COUNT; op += 1)
+    for(flags = 0; flags < SAT_RELATION_FLAG_COUNT; flags += 1)
+    for(alias = 0; alias < 2; alias += 1)
+    for(a = 0; a < 4; a += 1)
+    for(l = 0; l < 4; l += 1)
+    for(r = 0; r < 4; r += 1) {
+        sat_revise_table[op][flags][alias][a][l][r] =
+            sat_revise_supports(op, flags, alias, SAT_FALSE, SAT_FALSE,
+                                a, l, r);
+    }
+}
+
+
+/*!
+@brief Revises the domains of all three variables in a single relation.
+@details Looks the new domains up in sat_revise_table, so there is no
+branching on the operation. Relations whose assignee is also an operand
+only come from sat_collapse_equivalences, and are handled by
+sat_revise_supports directly.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] rel - The relation to revise, indexed by its assignee.
+@returns A mask of SAT_REVISED_* bits saying which participants changed.
 */
 t_sat_bool sat_solve_arc_reduce(
     sat_imp_matrix * imp_mat,
     sat_var_idx      rel 
 ){
-    
-    sat_var_idx lhs = imp_mat -> lhs[rel];
-    sat_var_idx rhs = imp_mat -> rhs[rel];
+    sat_relation  r   = imp_mat -> relations[rel];
+    sat_var_idx   lhs = r.lhs;
+    sat_var_idx   rhs = r.rhs;
+
+    t_sat_bool a_dom = sat_get_domain_bits(imp_mat, rel);
+    t_sat_bool l_dom = sat_get_domain_bits(imp_mat, lhs);
+    t_sat_bool r_dom = sat_get_domain_bits(imp_mat, rhs);
+
+    unsigned char old_doms = a_dom | l_dom << 2 | r_dom << 4;
+    unsigned char new_doms;
+
+    if(rel != lhs && rel != rhs) {
+        new_doms = sat_revise_table[r.op][r.flags][lhs == rhs]
+                                   [a_dom][l_dom][r_dom];
+    } else {
+        new_doms = sat_revise_supports(r.op, r.flags, lhs == rhs, rel == lhs,
+                                       rel == rhs, a_dom, l_dom, r_dom);
+    }
 
-    //printf("%d %d %d\n", rel, lhs, rhs);
+    sat_set_domain_bits(imp_mat, rel,  new_doms       & SAT_DOMAIN_ALL);
+    sat_set_domain_bits(imp_mat, lhs, (new_doms >> 2) & SAT_DOMAIN_ALL);
+    sat_set_domain_bits(imp_mat, rhs, (new_doms >> 4) & SAT_DOMAIN_ALL);
 
-    t_sat_bool d0     = imp_mat -> domain_0[rel];
-    t_sat_bool d1     = imp_mat -> domain_1[rel];
+    // Fold each changed two bit field down to a single SAT_REVISED_* bit.
+    unsigned char changed = old_doms ^ new_doms;
+    changed = (changed | changed >> 1) & 0x15;
 
-    t_sat_bool l_cb0  = imp_mat -> domain_0[lhs];
-    t_sat_bool l_cb1  = imp_mat -> domain_1[lhs];
-    
-    t_sat_bool r_cb0  = imp_mat -> domain_0[rhs];
-    t_sat_bool r_cb1  = imp_mat -> domain_1[rhs];
-    
-    t_sat_bool acb0 = d0;
-    t_sat_bool acb1 = d1;
-
-    //printf("rel %d - d0 = %d, d1 = %d\n",rel ,d0,d1);
-    //printf("lhs %d - d0 = %d, d1 = %d\n",lhs ,l_cb0, l_cb1);
-    //printf("rhs %d - d0 = %d, d1 = %d\n",rhs ,r_cb0, r_cb1);
-
-    switch(imp_mat -> op[rel]) {
-        case(SAT_OR):
-            acb0 = l_cb0 && r_cb0;
-            acb1 = l_cb1 || r_cb1;
-            break;
-        case(SAT_NOR):
-            acb0 = l_cb1 || r_cb1;
-            acb1 = l_cb0 && r_cb0;
-            break;
-        case(SAT_XOR):
-            acb0 = (l_cb1 && r_cb1) || (l_cb0 && r_cb0);
-            acb1 = (l_cb0 && r_cb1) || (l_cb1 && r_cb0);
-            break;
-        case(SAT_NXOR):
-            acb0 = (l_cb0 && r_cb1) || (l_cb1 && r_cb0);
-            acb1 = (l_cb1 && r_cb1) || (l_cb0 && r_cb0);
-            break;
-        case(SAT_AND):
-            acb0 = l_cb0 || r_cb0;
-            acb1 = l_cb1 && r_cb1;
-            break;
-        case(SAT_NAND):
-            //printf("%d = %d NAND %d\n", rel, lhs, rhs);
-            acb0 = l_cb1 && r_cb1;
-            acb1 = l_cb0 || r_cb0;
-            break;
-        case(SAT_IMP ):
-            acb0 = l_cb1 && r_cb0;
-            acb1 = l_cb0 || (l_cb1 && r_cb1);
-            break;
-        case(SAT_EQ):
-            //printf("%d EQ %d\n", rel, rhs);
-            acb0 = r_cb0;
-            acb1 = r_cb1;
-            break;
-        case(SAT_INPUT):
-        default: 
-            //printf("%d INPUT\n", rel);
-            acb0 = d0;
-            acb1 = d1;
-            break;
-    }
-
-    //printf("rel %d - acb0 = %d, acb1 = %d\n",rel ,acb0,acb1);
-    imp_mat -> domain_0[rel] = acb0;
-    imp_mat -> domain_1[rel] = acb1;
-
-    return (acb0 != d0) || (acb1 != d1);
+    return (changed & 0x1) | ((changed >> 1) & 0x2) | ((changed >> 2) & 0x4);
+}
+
+
+/*!
+@brief Revises a single relation while other threads may be revising
+relations which share its variables or domain words.
+@details Identical to sat_solve_arc_reduce except that domains are read
+atomically and narrowed with sat_narrow_domain_bits. Only values this call
+actually removed are reported as changes.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] rel - The relation to revise, indexed by its assignee.
+@returns A mask of SAT_REVISED_* bits saying which participants this call
+narrowed.
+*/
+t_sat_bool sat_solve_arc_reduce_shared(
+    sat_imp_matrix * imp_mat,
+    sat_var_idx      rel
+){
+    sat_relation  r   = imp_mat -> relations[rel];
+    sat_var_idx   lhs = r.lhs;
+    sat_var_idx   rhs = r.rhs;
+
+    t_sat_bool a_dom = sat_load_domain_bits(imp_mat, rel);
+    t_sat_bool l_dom = sat_load_domain_bits(imp_mat, lhs);
+    t_sat_bool r_dom = sat_load_domain_bits(imp_mat, rhs);
+
+    unsigned char new_doms;
+
+    if(rel != lhs && rel != rhs) {
+        new_doms = sat_revise_table[r.op][r.flags][lhs == rhs]
+                                   [a_dom][l_dom][r_dom];
+    } else {
+        new_doms = sat_revise_supports(r.op, r.flags, lhs == rhs, rel == lhs,
+                                       rel == rhs, a_dom, l_dom, r_dom);
+    }
+
+    t_sat_bool a_new = new_doms        & SAT_DOMAIN_ALL;
+    t_sat_bool l_new = (new_doms >> 2) & SAT_DOMAIN_ALL;
+    t_sat_bool r_new = (new_doms >> 4) & SAT_DOMAIN_ALL;
+    t_sat_bool tr    = 0;
+
+    // Skip the atomic write entirely when nothing is removed, which is by
+    // far the most common case.
+    if(a_new != a_dom && (sat_narrow_domain_bits(imp_mat, rel, a_new) &
+                          ~a_new)) {
+        tr |= SAT_REVISED_ASSIGNEE;
+    }
+    if(l_new != l_dom && (sat_narrow_domain_bits(imp_mat, lhs, l_new) &
+                          ~l_new)) {
+        tr |= SAT_REVISED_LHS;
+    }
+    if(r_new != r_dom && (sat_narrow_domain_bits(imp_mat, rhs, r_new) &
+                          ~r_new)) {
+        tr |= SAT_REVISED_RHS;
+    }
+
+    return tr;
+}
+
+
+/*!
+@brief Add every relation which could be narrowed by a change to the
+domain of variable to the worklist.
+@details This is the relation which assigns to the variable (unless it is an
+input) and all of the relations which read it, apart from `skip`, which has
+just been revised and is already arc consistent.
+*/
+static void sat_solve_enqueue_dependents(
+    sat_imp_matrix * imp_mat,
+    worklist       * pending,
+    sat_var_idx      variable,
+    sat_var_idx      skip
+){
+    if(variable != skip && imp_mat -> relations[variable].op != SAT_INPUT) {
+        worklist_enqueue(pending, variable);
+    }
+
+    unsigned int f   = imp_mat -> fanout_start[variable    ];
+    unsigned int end = imp_mat -> fanout_start[variable + 1];
+
+    for (; f < end; f += 1) {
+        if(imp_mat -> fanout[f] != skip) {
+            worklist_enqueue(pending, imp_mat -> fanout[f]);
+        }
+    }
+}
+
+
+/*!
+@brief Build the reverse dependency (fanout) index of the matrix.
+@details For every variable, records which relations take it as an lhs or
+rhs operand, so that when the domain of a variable changes only those
+relations need to be revisited. Input variables have no operands and so
+never appear in the index.
+@param [inout] imp_mat - The matrix to operate on.
+@returns void
+*/
+void sat_build_fanout(
+    sat_imp_matrix * imp_mat
+){
+    assert(imp_mat != NULL);
+
+    sat_own_imp_matrix(imp_mat);
+
+    unsigned int   n      = imp_mat -> variable_count;
+    unsigned int * start  = calloc(n + 1, sizeof(unsigned int));
+    sat_var_idx    i;
+
+    // Count how many relations read each variable. A relation whose lhs
+    // and rhs are the same variable (eg. NOT) is only counted once.
+    for(i = 0; i < n; i += 1) {
+        sat_relation * r = &imp_mat -> relations[i];
+
+        if(r -> op == SAT_INPUT) continue;
+
+        start[r -> lhs + 1] += 1;
+        if(r -> rhs != r -> lhs) {
+            start[r -> rhs + 1] += 1;
+        }
+    }
+
+    // Turn the counts into offsets.
+    for(i = 0; i < n; i += 1) {
+        start[i + 1] += start[i];
+    }
+
+    sat_var_idx  * fanout = calloc(start[n] > 0 ? start[n] : 1,
+                                   sizeof(sat_var_idx));
+    unsigned int * fill   = calloc(n, sizeof(unsigned int));
+
+    for(i = 0; i < n; i += 1) {
+        if(imp_mat -> relations[i].op == SAT_INPUT) continue;
+
+        sat_var_idx l = imp_mat -> relations[i].lhs;
+        sat_var_idx r = imp_mat -> relations[i].rhs;
+
+        fanout[start[l] + fill[l]] = i;
+        fill[l] += 1;
+
+        if(r != l) {
+            fanout[start[r] + fill[r]] = i;
+            fill[r] += 1;
+        }
+    }
+
+    free(fill);
+    free(imp_mat -> fanout_start);
+    free(imp_mat -> fanout      );
+
+    imp_mat -> fanout_start = start;
+    imp_mat -> fanout       = fanout;
+    imp_mat -> fanout_stale = SAT_FALSE;
 }
 
 
@@ -265,47 +768,84 @@ t_sat_bool sat_solve_arc_reduce(
 t_sat_bool sat_solve(
     sat_imp_matrix * imp_mat
 ) {
+    return sat_solve_until(imp_mat, NULL);
+}
+
+
+/*!
+@brief Solve the constraint problem represented by the supplied matrix,
+giving up early if another thread asks.
+@details The flag is read once per revision, so a solve stops within one
+relation of it being raised.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] abort - If not NULL, a flag which is set to stop the solve.
+@returns True if the system is solvable, and the solve was not stopped.
+*/
+t_sat_bool sat_solve_until(
+    sat_imp_matrix   * imp_mat,
+    const t_sat_bool * abort
+) {
     
-    queue * worklist = queue_new();
+    // Contradictory unary constraints leave nothing to propagate.
+    if(sat_any_domain_empty(imp_mat)) {
+        return SAT_FALSE;
+    }
+
+    if(imp_mat -> fanout_stale) {
+        sat_build_fanout(imp_mat);
+    }
 
+    worklist * pending = worklist_new(imp_mat -> variable_count);
+
+    // Inputs have no relation to revise, which includes every relation
+    // deleted by sat_prune_to_cone or sat_fold_constants.
     sat_var_idx i = 0;
     for (i = 0; i < imp_mat -> variable_count; i +=1) {
-        sat_var_idx * vid = calloc(1, sizeof(sat_var_idx));
-        vid[0] = i;
-        queue_enqueue(worklist, vid);
+        if(imp_mat -> relations[i].op != SAT_INPUT) {
+            worklist_enqueue(pending, i);
+        }
     }
 
-    while(worklist -> length > 0) {
+    while(pending -> length > 0) {
+
+        if(abort != NULL && __atomic_load_n(abort, __ATOMIC_RELAXED)) {
+            worklist_free(pending);
+            return SAT_FALSE;
+        }
+
+        sat_var_idx relation = worklist_dequeue(pending);
+        t_sat_bool  revised  = sat_solve_arc_reduce(imp_mat,relation);
 
-        sat_var_idx * v = queue_dequeue(worklist);
-        sat_var_idx relation = v[0];
-        free(v);
+        if(revised) {
 
-        if(sat_solve_arc_reduce(imp_mat,relation)) {
+            // Every participant of the relation loses all support at once,
+            // so checking the assignee is enough to detect a conflict.
             if(sat_domain_empty(imp_mat,relation))
             {
                 // Fail
-                free(worklist);
+                worklist_free(pending);
                 return SAT_FALSE;
             }
-            else
-            {
-                // Checked relation a on x y
-                // Now check all relations w,z on a
-                for (i = 0; i < imp_mat -> variable_count; i +=1) {
-
-                    if(imp_mat -> lhs[i] == relation ||
-                       imp_mat -> rhs[i] == relation) {
-
-                        sat_var_idx * vid = calloc(1, sizeof(sat_var_idx));
-                        vid[0] = i;
-                        queue_enqueue(worklist, vid);
-                    }
-                }
+
+            // Checked relation a on x y
+            // Now check all relations on whichever of a, x, y changed.
+            sat_relation * r = &imp_mat -> relations[relation];
+
+            if(revised & SAT_REVISED_ASSIGNEE) {
+                sat_solve_enqueue_dependents(imp_mat, pending, relation,
+                                             relation);
+            }
+            if(revised & SAT_REVISED_LHS) {
+                sat_solve_enqueue_dependents(imp_mat, pending, r -> lhs,
+                                             relation);
+            }
+            if(revised & SAT_REVISED_RHS) {
+                sat_solve_enqueue_dependents(imp_mat, pending, r -> rhs,
+                                             relation);
             }
         }
     }
 
-    free(worklist);
+    worklist_free(pending);
     return SAT_TRUE;
 }
@@ -4,6 +4,7 @@
 #include <assert.h>
 
 #include "queue.h"
+#include "worklist.h"
 #include "satsolver.h"
 
 #ifndef H_IMP_MATRIX
@@ -30,6 +31,22 @@ typedef unsigned int  sat_var_idx;
 //! @typedef A string representing the name of a single boolean variable.
 typedef char * sat_var_name;
 
+//! @typedef A machine word holding the packed domains of several variables.
+typedef unsigned long long sat_domain_word;
+
+//! The number of variable domains packed into a single sat_domain_word.
+#define SAT_DOMAINS_PER_WORD    32
+
+//! A packed domain which includes 0.
+#define SAT_DOMAIN_0            0x1
+//! A packed domain which includes 1.
+#define SAT_DOMAIN_1            0x2
+//! A packed domain which includes both 0 and 1.
+#define SAT_DOMAIN_ALL          0x3
+
+//! Selects the low (can be 0) bit of every domain in a sat_domain_word.
+#define SAT_DOMAIN_LOW_BITS     0x5555555555555555ULL
+
 //! Describes a single binary operation on two variables.
 typedef enum e_sat_binary_op {
     SAT_INPUT =0,   //!< No operation, variable is an input.
@@ -45,8 +62,43 @@ typedef enum e_sat_binary_op {
     SAT_NOP=10          //!< No-op
 } sat_binary_op;
 
+//! The number of members of sat_binary_op.
+#define SAT_OP_COUNT            11
+
+//! Truth table entry for operations which do not constrain their operands.
+#define SAT_OP_UNCONSTRAINED    0x100
+
+//! Returned by sat_solve_arc_reduce when the assignee domain was narrowed.
+#define SAT_REVISED_ASSIGNEE    0x1
+//! Returned by sat_solve_arc_reduce when the lhs domain was narrowed.
+#define SAT_REVISED_LHS         0x2
+//! Returned by sat_solve_arc_reduce when the rhs domain was narrowed.
+#define SAT_REVISED_RHS         0x4
+
 //  ------------------ Data Structures -----------------------------------
 
+//! Relation flag: the operation reads the inverse of the lhs.
+#define SAT_RELATION_NEGATE_LHS 0x1
+//! Relation flag: the operation reads the inverse of the rhs.
+#define SAT_RELATION_NEGATE_RHS 0x2
+//! The number of combinations of SAT_RELATION_NEGATE_* flags.
+#define SAT_RELATION_FLAG_COUNT 4
+
+/*!
+@brief A single relation `assignee = lhs op rhs`, stored at the index of its
+assignee.
+@details Operands and operation are packed into one 12 byte record, so
+revising a relation reads a single record rather than gathering from a
+separate array per field.
+*/
+typedef struct s_sat_relation {
+    sat_var_idx     lhs;    //!< Variable on LHS of operation.
+    sat_var_idx     rhs;    //!< Variable on RHS of operation.
+    unsigned char   op;     //!< The sat_binary_op being performed.
+    unsigned char   flags;  //!< SAT_RELATION_NEGATE_* bits.
+    unsigned char   pad[2]; //!< Keeps the record a multiple of 4 bytes.
+} sat_relation;
+
 /*!
 @brief This structure contains a complete description of an implication
        matrix used to record relationships between variables.
@@ -55,17 +107,55 @@ typedef struct s_sat_imp_matrix {
     
     //! The number of variables the matrix holds relations for.
     unsigned int    variable_count;
-
-    //! Does the domain of a variable include 0?
-    t_sat_bool   *  domain_0;
-    //! Does the domain of a variable include 1?
-    t_sat_bool   *  domain_1;
-    //! Variable on LHS of operation.
-    sat_var_idx  *  lhs;
-    //! variable on RHS of operation
-    sat_var_idx  *  rhs;
-    //! The operation being performed.
-    sat_binary_op * op;
+    //! The number of variables storage has been allocated for.
+    unsigned int    capacity;
+
+    /*!
+    @brief Packed domains of every variable, SAT_DOMAINS_PER_WORD to a word.
+    @details Variable v owns bits 2*(v % SAT_DOMAINS_PER_WORD) and the one
+    above it in word v / SAT_DOMAINS_PER_WORD. The low bit is set iff the
+    domain includes 0, the high bit iff it includes 1. Bits past the last
+    variable are always set, so they look like unconstrained variables.
+    */
+    sat_domain_word * domains;
+    //! The relation which assigns to each variable, indexed by variable.
+    sat_relation *  relations;
+
+    /*!
+    @brief Offset into fanout of the first relation which reads each variable.
+    @details Has variable_count+1 entries, such that the relations reading
+    variable v are fanout[fanout_start[v]] .. fanout[fanout_start[v+1]-1].
+    */
+    unsigned int *  fanout_start;
+    //! Relations which read each variable as an operand, grouped by variable.
+    sat_var_idx  *  fanout;
+    //! Set whenever a relation changes and the fanout index must be rebuilt.
+    t_sat_bool      fanout_stale;
+
+    /*!
+    @brief Every non-input relation, sorted by topological level.
+    @details Level 0 relations read only inputs, and every other relation
+    reads at least one variable assigned on the level below it. The
+    relations on level L are level_order[level_start[L]] ..
+    level_order[level_start[L+1]-1]. Only valid if levels_acyclic is set.
+    */
+    sat_var_idx  *  level_order;
+    //! Offset into level_order of the first relation on each level.
+    unsigned int *  level_start;
+    //! The number of levels in level_order.
+    unsigned int    level_count;
+    //! Set if the relations form a DAG, so level_order is valid.
+    t_sat_bool      levels_acyclic;
+    //! Set whenever a relation changes and the levels must be rebuilt.
+    t_sat_bool      levels_stale;
+
+    /*!
+    @brief Set if domains, relations and the fanout index live in memory
+    owned by someone else, such as a mapped compiled file.
+    @details They are copied before the matrix first needs to grow them or
+    rebuild the index, and are never freed by the matrix.
+    */
+    t_sat_bool      borrowed;
     
 } sat_imp_matrix;
 
@@ -78,10 +168,11 @@ typedef struct s_sat_imp_matrix {
 /*!
 @brief Allocates a new implication matrix object with the required number
 of cells to handle variable_count variables.
-@param [in] variable_count - The number of variables the matrix must hold.
+@param [in] variable_count - The number of variables the matrix must hold
+initially. May be zero, in which case the matrix grows as relations are added.
 @returns A pointer to a newly created implication matrix object or NULL if
 the matrix allocation failed.
-@see sat_imp_matrix sat_free_imp_matrix
+@see sat_imp_matrix sat_free_imp_matrix sat_resize_imp_matrix
 */
 sat_imp_matrix * sat_new_imp_matrix(
     unsigned int variable_count
@@ -89,6 +180,46 @@ sat_imp_matrix * sat_new_imp_matrix(
 
 
 
+/*!
+@brief Create a matrix around arrays which belong to someone else.
+@details Used to solve a compiled problem straight out of a mapped file.
+The arrays must stay valid until the matrix is freed. Domains may be
+written to, so they must be private to this matrix.
+@param [in] variable_count - The number of variables.
+@param [in] domains - Packed domains, with the bits past the last variable
+set.
+@param [in] relations - One relation per variable.
+@param [in] fanout_start - The fanout offsets, variable_count+1 of them.
+@param [in] fanout - The fanout index which matches relations.
+@returns A pointer to a newly created implication matrix object.
+@see sat_imp_matrix sat_free_imp_matrix sat_build_fanout
+*/
+sat_imp_matrix * sat_new_borrowed_imp_matrix(
+    unsigned int      variable_count,
+    sat_domain_word * domains,
+    sat_relation    * relations,
+    unsigned int    * fanout_start,
+    sat_var_idx     * fanout
+);
+
+
+/*!
+@brief Grow an implication matrix so it can hold at least variable_count
+variables.
+@details New variables start as unconstrained inputs. Does nothing if the
+matrix is already big enough. sat_add_relation and sat_set_domain call this
+automatically, so a matrix can be built up incrementally.
+@param [inout] imp_mat - The matrix to grow.
+@param [in] variable_count - The number of variables the matrix must hold.
+@returns void
+*/
+void sat_resize_imp_matrix(
+    sat_imp_matrix * imp_mat,
+    unsigned int     variable_count
+);
+
+
+
 /*!
 @brief Frees an implication matrix object from memory.
 @param [in] imp_mat - The implication matrix to be free'd.
@@ -194,6 +325,180 @@ t_sat_bool sat_domain_empty(
 );
 
 
+/*!
+@brief Get the packed domain of a variable.
+@param [in] imp_mat - The matrix to operate on.
+@param [in] variable - The variable who's domain we are querying.
+@returns A combination of SAT_DOMAIN_0 and SAT_DOMAIN_1.
+*/
+static inline t_sat_bool sat_get_domain_bits(
+    sat_imp_matrix * imp_mat,
+    sat_var_idx      variable
+){
+    unsigned int shift = 2 * (variable % SAT_DOMAINS_PER_WORD);
+    return (imp_mat -> domains[variable / SAT_DOMAINS_PER_WORD] >> shift) &
+           SAT_DOMAIN_ALL;
+}
+
+
+/*!
+@brief Set the packed domain of a variable.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] variable - The variable who's domain we are updating.
+@param [in] bits - A combination of SAT_DOMAIN_0 and SAT_DOMAIN_1.
+*/
+static inline void sat_set_domain_bits(
+    sat_imp_matrix * imp_mat,
+    sat_var_idx      variable,
+    t_sat_bool       bits
+){
+    unsigned int      shift = 2 * (variable % SAT_DOMAINS_PER_WORD);
+    sat_domain_word * word  = &imp_mat -> domains[variable /
+                                                  SAT_DOMAINS_PER_WORD];
+
+    *word = (*word & ~((sat_domain_word)SAT_DOMAIN_ALL << shift)) |
+            ((sat_domain_word)bits << shift);
+}
+
+
+/*!
+@brief Atomically read the packed domain of a variable.
+@details Safe to call while other threads narrow domains in the same word.
+@param [in] imp_mat - The matrix to operate on.
+@param [in] variable - The variable who's domain we are reading.
+@returns A combination of SAT_DOMAIN_0 and SAT_DOMAIN_1.
+*/
+static inline t_sat_bool sat_load_domain_bits(
+    sat_imp_matrix * imp_mat,
+    sat_var_idx      variable
+){
+    unsigned int shift = 2 * (variable % SAT_DOMAINS_PER_WORD);
+    return (__atomic_load_n(&imp_mat -> domains[variable /
+                                                SAT_DOMAINS_PER_WORD],
+                            __ATOMIC_SEQ_CST) >> shift) & SAT_DOMAIN_ALL;
+}
+
+
+/*!
+@brief Atomically remove values from the packed domain of a variable.
+@details Safe to call while other threads narrow domains in the same word.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] variable - The variable who's domain we are narrowing.
+@param [in] bits - The values to keep, a combination of SAT_DOMAIN_0 and
+SAT_DOMAIN_1.
+@returns The domain of the variable immediately before it was narrowed.
+*/
+static inline t_sat_bool sat_narrow_domain_bits(
+    sat_imp_matrix * imp_mat,
+    sat_var_idx      variable,
+    t_sat_bool       bits
+){
+    unsigned int      shift = 2 * (variable % SAT_DOMAINS_PER_WORD);
+    sat_domain_word * word  = &imp_mat -> domains[variable /
+                                                  SAT_DOMAINS_PER_WORD];
+    sat_domain_word   keep  = ~((sat_domain_word)(~bits & SAT_DOMAIN_ALL)
+                                << shift);
+
+    return (__atomic_fetch_and(word, keep, __ATOMIC_SEQ_CST) >> shift) &
+           SAT_DOMAIN_ALL;
+}
+
+
+/*!
+@brief Count the variables whose domain does not include a value.
+@details Works a whole sat_domain_word at a time using popcount.
+@param [in] imp_mat - The matrix to operate on.
+@param [in] value - The value to look for.
+@returns The number of variables which cannot take the value.
+*/
+unsigned int sat_count_excluded(
+    sat_imp_matrix * imp_mat,
+    t_sat_bool       value
+);
+
+
+/*!
+@brief Count the variables whose domain is empty.
+@details Works a whole sat_domain_word at a time using popcount.
+@param [in] imp_mat - The matrix to operate on.
+@returns The number of variables with an empty domain.
+*/
+unsigned int sat_count_empty_domains(
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Check whether any variable has an empty domain.
+@details Works a whole sat_domain_word at a time and stops at the first
+empty domain found.
+@param [in] imp_mat - The matrix to operate on.
+@returns SAT_TRUE if some variable has an empty domain.
+*/
+t_sat_bool sat_any_domain_empty(
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Build the reverse dependency (fanout) index of the matrix.
+@details For every variable, records which relations take it as an lhs or
+rhs operand, so that when the domain of a variable changes only those
+relations need to be revisited. Should be called once all relations have
+been added. sat_solve will call this automatically if the index is stale.
+@param [inout] imp_mat - The matrix to operate on.
+@returns void
+*/
+void sat_build_fanout(
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Returns the truth table of a relation, with any negated operands
+taken into account.
+@param [in] r - The relation.
+@returns SAT_OP_UNCONSTRAINED if the relation constrains nothing, otherwise
+a table whose bit (2*l + r) is the value the assignee takes when the lhs is
+l and the rhs is r.
+*/
+unsigned short sat_relation_truth(
+    sat_relation * r
+);
+
+
+/*!
+@brief Revises the domains of all three variables in a single relation.
+@details Removes every value from the domains of the assignee, lhs and rhs
+of the relation which has no support in the other two domains.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] rel - The relation to revise, indexed by its assignee.
+@returns A mask of SAT_REVISED_* bits saying which participants changed.
+*/
+t_sat_bool sat_solve_arc_reduce(
+    sat_imp_matrix * imp_mat,
+    sat_var_idx      rel
+);
+
+
+/*!
+@brief Revises a single relation while other threads may be revising
+relations which share its variables or domain words.
+@details Domains are read atomically and narrowed with an atomic AND, so
+values can only ever be removed. A domain read before another thread
+narrowed it gives a weaker but still sound result, and the caller must
+revise the relation again once it sees that change.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] rel - The relation to revise, indexed by its assignee.
+@returns A mask of SAT_REVISED_* bits saying which participants this call
+narrowed.
+*/
+t_sat_bool sat_solve_arc_reduce_shared(
+    sat_imp_matrix * imp_mat,
+    sat_var_idx      rel
+);
+
+
 /*!
 @brief Solve the constraint problem represented by the supplied matrix.
 @param [inout] imp_mat - The matrix to operate on.
@@ -203,6 +508,22 @@ t_sat_bool sat_solve(
     sat_imp_matrix * imp_mat
 );
 
+
+/*!
+@brief Solve the constraint problem represented by the supplied matrix,
+giving up early if another thread asks.
+@details Behaves exactly as sat_solve while the flag is clear. Once it is
+set the solve returns as soon as it notices, leaving the domains partly
+narrowed.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] abort - If not NULL, a flag which is set to stop the solve.
+@returns True if the system is solvable, and the solve was not stopped.
+*/
+t_sat_bool sat_solve_until(
+    sat_imp_matrix   * imp_mat,
+    const t_sat_bool * abort
+);
+
 /*! @} */
 
 #endif
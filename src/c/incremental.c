@@ -0,0 +1,320 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "incremental.h"
+
+//! Passed as `skip` when no relation should be skipped.
+#define SAT_NO_RELATION ((sat_var_idx)-1)
+
+
+/*!
+@brief Record the domain of a variable on the trail before it changes.
+*/
+static void sat_incremental_record(
+    sat_incremental * inc,
+    sat_var_idx       variable,
+    t_sat_bool        old
+){
+    if(inc -> trail_length == inc -> trail_capacity) {
+        inc -> trail_capacity = inc -> trail_capacity ?
+                                inc -> trail_capacity * 2 : 64;
+        inc -> trail_var = realloc(inc -> trail_var, inc -> trail_capacity *
+                                   sizeof(sat_var_idx));
+        inc -> trail_old = realloc(inc -> trail_old, inc -> trail_capacity *
+                                   sizeof(t_sat_bool));
+    }
+
+    inc -> trail_var[inc -> trail_length] = variable;
+    inc -> trail_old[inc -> trail_length] = old;
+    inc -> trail_length += 1;
+}
+
+
+/*!
+@brief Add every relation which could be narrowed by a change to the
+domain of variable to the worklist, apart from `skip`.
+*/
+static void sat_incremental_enqueue_dependents(
+    sat_incremental * inc,
+    sat_var_idx       variable,
+    sat_var_idx       skip
+){
+    sat_imp_matrix * imp_mat = inc -> imp_mat;
+
+    if(variable != skip && !sat_is_input(imp_mat, variable)) {
+        worklist_enqueue(inc -> pending, variable);
+    }
+
+    unsigned int f   = imp_mat -> fanout_start[variable    ];
+    unsigned int end = imp_mat -> fanout_start[variable + 1];
+
+    for (; f < end; f += 1) {
+        if(imp_mat -> fanout[f] != skip) {
+            worklist_enqueue(inc -> pending, imp_mat -> fanout[f]);
+        }
+    }
+}
+
+
+/*!
+@brief Make sure the fanout index and worklist cover every variable.
+*/
+static void sat_incremental_prepare(
+    sat_incremental * inc
+){
+    sat_imp_matrix * imp_mat = inc -> imp_mat;
+
+    if(imp_mat -> fanout_stale) {
+        sat_build_fanout(imp_mat);
+    }
+
+    if(inc -> pending == NULL) {
+        inc -> pending = worklist_new(imp_mat -> capacity);
+    } else if(inc -> pending -> capacity < imp_mat -> variable_count) {
+        worklist_free(inc -> pending);
+        inc -> pending = worklist_new(imp_mat -> capacity);
+    }
+}
+
+
+/*!
+@brief Revise relations until the worklist is empty.
+@param [inout] inc - The solver to propagate.
+@param [in] record - Whether to record changes on the trail, which is only
+done during a query.
+@returns False on a conflict, in which case the worklist is emptied.
+*/
+static t_sat_bool sat_incremental_run(
+    sat_incremental * inc,
+    t_sat_bool        record
+){
+    sat_imp_matrix * imp_mat = inc -> imp_mat;
+
+    while(inc -> pending -> length > 0) {
+
+        sat_var_idx    relation = worklist_dequeue(inc -> pending);
+        sat_relation * r        = &imp_mat -> relations[relation];
+        t_sat_bool     a_old    = sat_get_domain_bits(imp_mat, relation);
+        t_sat_bool     l_old    = sat_get_domain_bits(imp_mat, r -> lhs);
+        t_sat_bool     r_old    = sat_get_domain_bits(imp_mat, r -> rhs);
+        t_sat_bool     revised  = sat_solve_arc_reduce(imp_mat, relation);
+
+        if(!revised) continue;
+
+        if(record) {
+            if(revised & SAT_REVISED_ASSIGNEE) {
+                sat_incremental_record(inc, relation, a_old);
+            }
+            if(revised & SAT_REVISED_LHS) {
+                sat_incremental_record(inc, r -> lhs, l_old);
+            }
+            if(revised & SAT_REVISED_RHS) {
+                sat_incremental_record(inc, r -> rhs, r_old);
+            }
+        }
+
+        if(sat_domain_empty(imp_mat, relation)) {
+            while(inc -> pending -> length > 0) {
+                worklist_dequeue(inc -> pending);
+            }
+            return SAT_FALSE;
+        }
+
+        if(revised & SAT_REVISED_ASSIGNEE) {
+            sat_incremental_enqueue_dependents(inc, relation, relation);
+        }
+        if(revised & SAT_REVISED_LHS) {
+            sat_incremental_enqueue_dependents(inc, r -> lhs, relation);
+        }
+        if(revised & SAT_REVISED_RHS) {
+            sat_incremental_enqueue_dependents(inc, r -> rhs, relation);
+        }
+    }
+
+    return SAT_TRUE;
+}
+
+
+/*!
+@brief Create an incremental solver for a matrix, and propagate it to its
+base state.
+@param [inout] imp_mat - The matrix to solve.
+@returns A new incremental solver.
+*/
+sat_incremental * sat_new_incremental(
+    sat_imp_matrix * imp_mat
+){
+    assert(imp_mat != NULL);
+
+    sat_incremental * tr = calloc(1, sizeof(sat_incremental));
+    tr -> imp_mat    = imp_mat;
+    tr -> consistent = sat_solve(imp_mat);
+
+    sat_incremental_prepare(tr);
+
+    return tr;
+}
+
+
+/*!
+@brief Free an incremental solver, rolling back any query first.
+@param [in] tofree - The solver to free.
+*/
+void sat_free_incremental(
+    sat_incremental * tofree
+){
+    sat_incremental_rollback(tofree);
+
+    worklist_free(tofree -> pending);
+    free(tofree -> added);
+    free(tofree -> trail_var);
+    free(tofree -> trail_old);
+    free(tofree);
+}
+
+
+/*!
+@brief Add a relation, to be propagated into the base state before the
+next query.
+@param [inout] inc - The solver to add the relation to.
+@param [in] assignee - The variable being assigned to.
+@param [in] lhs - Left hand side of the operation.
+@param [in] op - The operation.
+@param [in] rhs - Right hand side of the operation.
+*/
+void sat_incremental_add_relation(
+    sat_incremental * inc,
+    sat_var_idx       assignee,
+    sat_var_idx       lhs,
+    sat_binary_op     op,
+    sat_var_idx       rhs
+){
+    assert(inc -> trail_length == 0 && !inc -> conflict);
+    assert(assignee >= inc -> imp_mat -> variable_count ||
+           sat_is_input(inc -> imp_mat, assignee));
+
+    sat_add_relation(inc -> imp_mat, assignee, lhs, op, rhs);
+
+    if(inc -> added_length == inc -> added_capacity) {
+        inc -> added_capacity = inc -> added_capacity ?
+                                inc -> added_capacity * 2 : 64;
+        inc -> added = realloc(inc -> added, inc -> added_capacity *
+                               sizeof(sat_var_idx));
+    }
+
+    inc -> added[inc -> added_length ++] = assignee;
+}
+
+
+/*!
+@brief Propagate any relations added since the last query into the base
+state.
+@param [inout] inc - The solver to update.
+@returns False if the base state is in conflict.
+*/
+t_sat_bool sat_incremental_settle(
+    sat_incremental * inc
+){
+    if(inc -> added_length == 0) {
+        return inc -> consistent;
+    }
+
+    assert(inc -> trail_length == 0);
+
+    sat_incremental_prepare(inc);
+
+    if(inc -> consistent) {
+        unsigned int i;
+        for(i = 0; i < inc -> added_length; i += 1) {
+            worklist_enqueue(inc -> pending, inc -> added[i]);
+        }
+        inc -> consistent = sat_incremental_run(inc, SAT_FALSE);
+    }
+
+    inc -> added_length = 0;
+    return inc -> consistent;
+}
+
+
+/*!
+@brief Assume that a variable takes a value for the current query.
+@param [inout] inc - The solver to query.
+@param [in] variable - The variable to narrow.
+@param [in] value - The value it must take.
+@returns False if the variable already cannot take the value.
+*/
+t_sat_bool sat_incremental_assume(
+    sat_incremental * inc,
+    sat_var_idx       variable,
+    t_sat_bool        value
+){
+    sat_imp_matrix * imp_mat = inc -> imp_mat;
+
+    assert(variable < imp_mat -> variable_count);
+
+    if(!sat_incremental_settle(inc) || inc -> conflict) {
+        return SAT_FALSE;
+    }
+
+    t_sat_bool old  = sat_get_domain_bits(imp_mat, variable);
+    t_sat_bool bits = value ? SAT_DOMAIN_1 : SAT_DOMAIN_0;
+
+    if(!(old & bits)) {
+        inc -> conflict = SAT_TRUE;
+        return SAT_FALSE;
+    }
+
+    if(old != bits) {
+        sat_incremental_record(inc, variable, old);
+        sat_set_domain_bits(imp_mat, variable, bits);
+        sat_incremental_prepare(inc);
+        sat_incremental_enqueue_dependents(inc, variable, SAT_NO_RELATION);
+    }
+
+    return SAT_TRUE;
+}
+
+
+/*!
+@brief Propagate the consequences of the assumptions made so far.
+@param [inout] inc - The solver to query.
+@returns False if the assumptions contradict the circuit.
+*/
+t_sat_bool sat_incremental_propagate(
+    sat_incremental * inc
+){
+    if(!sat_incremental_settle(inc) || inc -> conflict) {
+        return SAT_FALSE;
+    }
+
+    sat_incremental_prepare(inc);
+    inc -> conflict = !sat_incremental_run(inc, SAT_TRUE);
+
+    return !inc -> conflict;
+}
+
+
+/*!
+@brief Undo every change made by the current query, returning the matrix
+to its base state.
+@details Changes are undone newest first, so a variable changed more than
+once ends up with the domain it had before its first change.
+@param [inout] inc - The solver to roll back.
+*/
+void sat_incremental_rollback(
+    sat_incremental * inc
+){
+    while(inc -> trail_length > 0) {
+        inc -> trail_length -= 1;
+        sat_set_domain_bits(inc -> imp_mat,
+                            inc -> trail_var[inc -> trail_length],
+                            inc -> trail_old[inc -> trail_length]);
+    }
+
+    while(inc -> pending -> length > 0) {
+        worklist_dequeue(inc -> pending);
+    }
+
+    inc -> conflict = SAT_FALSE;
+}
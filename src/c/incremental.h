@@ -0,0 +1,142 @@
+
+#include "imp-matrix.h"
+#include "worklist.h"
+
+#ifndef H_INCREMENTAL
+#define H_INCREMENTAL
+
+/*!
+@defgroup gr-incremental Incremental Solving
+
+@brief Ask many questions about one circuit without rebuilding it.
+
+@details An incremental solver owns a matrix which has already been
+propagated to its base state. Each query narrows some domains with
+assumptions such as `x == 0`, and propagates only the consequences of those
+assumptions. Every domain change a query makes is recorded on an undo
+trail, so rolling back to the base state costs time proportional to what
+the query changed rather than to the size of the circuit.
+
+Between queries, new relations may be added. They are propagated into the
+base state together, just before the next query starts, so adding many
+relations only rebuilds the fanout index once.
+
+@addtogroup gr-incremental
+@{
+*/
+
+/*!
+@brief A matrix together with the trail of changes made by the current
+query.
+*/
+typedef struct sat_incremental_t {
+    sat_imp_matrix * imp_mat;       //!< The matrix in its base state.
+    worklist       * pending;       //!< Relations waiting to be revised.
+    sat_var_idx    * trail_var;     //!< Variables changed by the query.
+    t_sat_bool     * trail_old;     //!< Their domains before the change.
+    unsigned int     trail_length;  //!< Number of changes on the trail.
+    unsigned int     trail_capacity;//!< Number of changes allocated.
+    sat_var_idx    * added;         //!< Relations not yet in the base state.
+    unsigned int     added_length;  //!< Number of relations in added.
+    unsigned int     added_capacity;//!< Number of relations allocated.
+    t_sat_bool       consistent;    //!< False once the base state conflicts.
+    t_sat_bool       conflict;      //!< Set when the current query conflicts.
+} sat_incremental;
+
+
+/*!
+@brief Create an incremental solver for a matrix, and propagate it to its
+base state.
+@details The solver does not take ownership of the matrix, but nothing else
+should change it while the solver is in use.
+@param [inout] imp_mat - The matrix to solve.
+@returns A new incremental solver.
+*/
+sat_incremental * sat_new_incremental(
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Free an incremental solver, rolling back any query first.
+@details The matrix itself is not freed.
+@param [in] tofree - The solver to free.
+*/
+void sat_free_incremental(
+    sat_incremental * tofree
+);
+
+
+/*!
+@brief Add a relation, to be propagated into the base state before the
+next query.
+@details The assignee must not already have a relation, since the base
+state may depend on the one it would replace. May not be called while a
+query is in progress.
+@param [inout] inc - The solver to add the relation to.
+@param [in] assignee - The variable being assigned to.
+@param [in] lhs - Left hand side of the operation.
+@param [in] op - The operation.
+@param [in] rhs - Right hand side of the operation.
+*/
+void sat_incremental_add_relation(
+    sat_incremental * inc,
+    sat_var_idx       assignee,
+    sat_var_idx       lhs,
+    sat_binary_op     op,
+    sat_var_idx       rhs
+);
+
+
+/*!
+@brief Assume that a variable takes a value for the current query.
+@details The assumption takes effect on the next call to
+sat_incremental_propagate. `y != 1` is the same as assuming `y == 0`.
+@param [inout] inc - The solver to query.
+@param [in] variable - The variable to narrow.
+@param [in] value - The value it must take.
+@returns False if the variable already cannot take the value.
+*/
+t_sat_bool sat_incremental_assume(
+    sat_incremental * inc,
+    sat_var_idx       variable,
+    t_sat_bool        value
+);
+
+
+/*!
+@brief Propagate the consequences of the assumptions made so far.
+@details May be called more than once per query, after more assumptions.
+@param [inout] inc - The solver to query.
+@returns False if the assumptions contradict the circuit.
+*/
+t_sat_bool sat_incremental_propagate(
+    sat_incremental * inc
+);
+
+
+/*!
+@brief Propagate any relations added since the last query into the base
+state.
+@details Happens automatically when a query starts, but can be called
+directly to find out whether the circuit still has a solution.
+@param [inout] inc - The solver to update.
+@returns False if the base state is in conflict.
+*/
+t_sat_bool sat_incremental_settle(
+    sat_incremental * inc
+);
+
+
+/*!
+@brief Undo every change made by the current query, returning the matrix
+to its base state.
+@param [inout] inc - The solver to roll back.
+*/
+void sat_incremental_rollback(
+    sat_incremental * inc
+);
+
+/*! @} */
+
+#endif
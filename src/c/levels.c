@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "levels.h"
+
+//! How many relations each thread takes from a level at a time.
+#define SAT_LEVEL_CHUNK 64
+
+
+/*!
+@brief Sort the relations of a matrix into topological levels.
+@details Uses Kahn's algorithm: a relation is ready once the relations
+assigning all of its non-input operands have been placed, and its level is
+one more than the deepest of them.
+@param [inout] imp_mat - The matrix to operate on.
+@returns SAT_TRUE if the relations are acyclic and the levels are valid.
+*/
+t_sat_bool sat_build_levels(
+    sat_imp_matrix * imp_mat
+){
+    assert(imp_mat != NULL);
+
+    if(imp_mat -> fanout_stale) {
+        sat_build_fanout(imp_mat);
+    }
+
+    unsigned int   n        = imp_mat -> variable_count;
+    unsigned int * pending  = calloc(n > 0 ? n : 1, sizeof(unsigned int));
+    unsigned int * level    = calloc(n > 0 ? n : 1, sizeof(unsigned int));
+    sat_var_idx  * ready    = calloc(n > 0 ? n : 1, sizeof(sat_var_idx));
+    unsigned int   total    = 0;
+    unsigned int   head     = 0;
+    unsigned int   tail     = 0;
+    sat_var_idx    i;
+
+    // Count the operands of each relation which are themselves assigned.
+    for(i = 0; i < n; i += 1) {
+        sat_relation * r = &imp_mat -> relations[i];
+
+        if(r -> op == SAT_INPUT) continue;
+
+        total += 1;
+
+        if(!sat_is_input(imp_mat, r -> lhs)) {
+            pending[i] += 1;
+        }
+        if(r -> rhs != r -> lhs && !sat_is_input(imp_mat, r -> rhs)) {
+            pending[i] += 1;
+        }
+        if(pending[i] == 0) {
+            ready[tail ++] = i;
+        }
+    }
+
+    // Place relations as they become ready, pushing levels down the fanout.
+    unsigned int level_count = 0;
+
+    while(head < tail) {
+
+        sat_var_idx  v   = ready[head ++];
+        unsigned int f   = imp_mat -> fanout_start[v    ];
+        unsigned int end = imp_mat -> fanout_start[v + 1];
+
+        if(level[v] + 1 > level_count) {
+            level_count = level[v] + 1;
+        }
+
+        for(; f < end; f += 1) {
+            sat_var_idx reader = imp_mat -> fanout[f];
+
+            if(level[reader] < level[v] + 1) {
+                level[reader] = level[v] + 1;
+            }
+
+            pending[reader] -= 1;
+            if(pending[reader] == 0) {
+                ready[tail ++] = reader;
+            }
+        }
+    }
+
+    free(imp_mat -> level_order);
+    free(imp_mat -> level_start);
+
+    imp_mat -> level_order    = NULL;
+    imp_mat -> level_start    = NULL;
+    imp_mat -> level_count    = 0;
+    imp_mat -> levels_stale   = SAT_FALSE;
+    imp_mat -> levels_acyclic = tail == total;
+
+    if(imp_mat -> levels_acyclic) {
+
+        // Bucket the relations by level, keeping the order they were placed
+        // in within each level so the sweep order is deterministic.
+        unsigned int * start = calloc(level_count + 1, sizeof(unsigned int));
+        sat_var_idx  * order = calloc(total > 0 ? total : 1,
+                                      sizeof(sat_var_idx));
+
+        for(i = 0; i < total; i += 1) {
+            start[level[ready[i]] + 1] += 1;
+        }
+        for(i = 0; i < level_count; i += 1) {
+            start[i + 1] += start[i];
+        }
+
+        // Re-use pending as the fill pointer of each level.
+        for(i = 0; i < level_count; i += 1) {
+            pending[i] = start[i];
+        }
+        for(i = 0; i < total; i += 1) {
+            order[pending[level[ready[i]]] ++] = ready[i];
+        }
+
+        imp_mat -> level_order = order;
+        imp_mat -> level_start = start;
+        imp_mat -> level_count = level_count;
+    }
+
+    free(pending);
+    free(level);
+    free(ready);
+
+    return imp_mat -> levels_acyclic;
+}
+
+
+/*!
+@brief Mark every relation which could be narrowed by a change to the
+domain of variable as dirty.
+@details This is the relation which assigns to the variable (unless it is an
+input) and all of the relations which read it, apart from `skip`.
+*/
+static void sat_levels_mark_dependents(
+    sat_imp_matrix * imp_mat,
+    unsigned char  * dirty,
+    sat_var_idx      variable,
+    sat_var_idx      skip
+){
+    if(variable != skip && !sat_is_input(imp_mat, variable)) {
+        dirty[variable] = SAT_TRUE;
+    }
+
+    unsigned int f   = imp_mat -> fanout_start[variable    ];
+    unsigned int end = imp_mat -> fanout_start[variable + 1];
+
+    for (; f < end; f += 1) {
+        if(imp_mat -> fanout[f] != skip) {
+            dirty[imp_mat -> fanout[f]] = SAT_TRUE;
+        }
+    }
+}
+
+
+/*!
+@brief Revise a relation if it is dirty, marking whatever it narrows.
+@returns -1 if a domain became empty, 1 if a domain was narrowed, else 0.
+*/
+static int sat_levels_revise(
+    sat_imp_matrix * imp_mat,
+    unsigned char  * dirty,
+    sat_var_idx      rel
+){
+    if(!dirty[rel]) {
+        return 0;
+    }
+
+    dirty[rel] = SAT_FALSE;
+
+    t_sat_bool revised = sat_solve_arc_reduce(imp_mat, rel);
+
+    if(!revised) {
+        return 0;
+    }
+
+    if(sat_domain_empty(imp_mat, rel)) {
+        return -1;
+    }
+
+    sat_relation * r = &imp_mat -> relations[rel];
+
+    if(revised & SAT_REVISED_ASSIGNEE) {
+        sat_levels_mark_dependents(imp_mat, dirty, rel, rel);
+    }
+    if(revised & SAT_REVISED_LHS) {
+        sat_levels_mark_dependents(imp_mat, dirty, r -> lhs, rel);
+    }
+    if(revised & SAT_REVISED_RHS) {
+        sat_levels_mark_dependents(imp_mat, dirty, r -> rhs, rel);
+    }
+
+    return 1;
+}
+
+
+/*!
+@brief Solve the constraint problem using levelized forward and reverse
+sweeps.
+@details Each sweep only revises relations which are dirty: those with a
+participant whose domain has changed since they were last revised. A
+forward sweep settles everything narrowed from the inputs towards the
+outputs in one pass, and a reverse sweep everything narrowed the other way.
+@param [inout] imp_mat - The matrix to operate on.
+@returns True if the system is solvable.
+*/
+t_sat_bool sat_solve_levelized(
+    sat_imp_matrix * imp_mat
+){
+    if(sat_any_domain_empty(imp_mat)) {
+        return SAT_FALSE;
+    }
+
+    if(imp_mat -> fanout_stale || imp_mat -> levels_stale) {
+        sat_build_levels(imp_mat);
+    }
+
+    if(!imp_mat -> levels_acyclic) {
+        return sat_solve(imp_mat);
+    }
+
+    unsigned int    total = imp_mat -> level_start[imp_mat -> level_count];
+    sat_var_idx   * order = imp_mat -> level_order;
+    unsigned char * dirty = calloc(imp_mat -> variable_count > 0 ?
+                                   imp_mat -> variable_count : 1, 1);
+    t_sat_bool      tr    = SAT_TRUE;
+    unsigned int    i;
+
+    for(i = 0; i < total; i += 1) {
+        dirty[order[i]] = SAT_TRUE;
+    }
+
+    int progress = 1;
+
+    while(progress && tr) {
+
+        progress = 0;
+
+        // Forward sweep, from the inputs to the outputs.
+        for(i = 0; i < total && tr; i += 1) {
+            int result = sat_levels_revise(imp_mat, dirty, order[i]);
+            tr        = result >= 0;
+            progress |= result;
+        }
+
+        // Reverse sweep, from the outputs back to the inputs.
+        for(i = total; i > 0 && tr; i -= 1) {
+            int result = sat_levels_revise(imp_mat, dirty, order[i - 1]);
+            tr        = result >= 0;
+            progress |= result;
+        }
+    }
+
+    free(dirty);
+    return tr;
+}
+
+
+#ifdef _OPENMP
+
+/*!
+@brief Mark every relation which could be narrowed by a change to the
+domain of variable as dirty, while other threads are doing the same.
+*/
+static void sat_levels_mark_dependents_shared(
+    sat_imp_matrix * imp_mat,
+    unsigned char  * dirty,
+    sat_var_idx      variable,
+    sat_var_idx      skip
+){
+    if(variable != skip && !sat_is_input(imp_mat, variable)) {
+        __atomic_store_n(&dirty[variable], SAT_TRUE, __ATOMIC_SEQ_CST);
+    }
+
+    unsigned int f   = imp_mat -> fanout_start[variable    ];
+    unsigned int end = imp_mat -> fanout_start[variable + 1];
+
+    for (; f < end; f += 1) {
+        if(imp_mat -> fanout[f] != skip) {
+            __atomic_store_n(&dirty[imp_mat -> fanout[f]], SAT_TRUE,
+                             __ATOMIC_SEQ_CST);
+        }
+    }
+}
+
+
+/*!
+@brief Revise a relation if it is dirty, marking whatever it narrows, while
+other threads revise relations in the same level.
+@details The dirty flag is cleared before the domains are read. A thread
+which narrows one of them afterwards sets the flag again, so the relation
+is revised once more on a later sweep.
+@returns True if a domain was narrowed.
+*/
+static t_sat_bool sat_levels_revise_shared(
+    sat_imp_matrix * imp_mat,
+    unsigned char  * dirty,
+    sat_var_idx      rel
+){
+    if(!__atomic_load_n(&dirty[rel], __ATOMIC_RELAXED) ||
+       !__atomic_exchange_n(&dirty[rel], SAT_FALSE, __ATOMIC_SEQ_CST)) {
+        return SAT_FALSE;
+    }
+
+    t_sat_bool revised = sat_solve_arc_reduce_shared(imp_mat, rel);
+
+    if(!revised) {
+        return SAT_FALSE;
+    }
+
+    sat_relation * r = &imp_mat -> relations[rel];
+
+    if(revised & SAT_REVISED_ASSIGNEE) {
+        sat_levels_mark_dependents_shared(imp_mat, dirty, rel, rel);
+    }
+    if(revised & SAT_REVISED_LHS) {
+        sat_levels_mark_dependents_shared(imp_mat, dirty, r -> lhs, rel);
+    }
+    if(revised & SAT_REVISED_RHS) {
+        sat_levels_mark_dependents_shared(imp_mat, dirty, r -> rhs, rel);
+    }
+
+    return SAT_TRUE;
+}
+
+#endif
+
+
+/*!
+@brief Solve the constraint problem by sweeping levels in parallel.
+@details Every thread takes part in every level, taking relations in chunks
+of SAT_LEVEL_CHUNK, and waits at a barrier before moving on to the next
+level. Domains only ever lose values, so the order in which threads narrow
+them does not change the fixed point that is reached.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] threads - How many threads to use, or 0 for the OpenMP default.
+@returns True if the system is solvable.
+*/
+t_sat_bool sat_solve_parallel(
+    sat_imp_matrix * imp_mat,
+    unsigned int     threads
+){
+#ifdef _OPENMP
+    if(sat_any_domain_empty(imp_mat)) {
+        return SAT_FALSE;
+    }
+
+    if(imp_mat -> fanout_stale || imp_mat -> levels_stale) {
+        sat_build_levels(imp_mat);
+    }
+
+    if(!imp_mat -> levels_acyclic) {
+        return sat_solve(imp_mat);
+    }
+
+    if(threads == 0) {
+        threads = omp_get_max_threads();
+    }
+
+    unsigned int    total = imp_mat -> level_start[imp_mat -> level_count];
+    unsigned int    count = imp_mat -> level_count;
+    unsigned int  * start = imp_mat -> level_start;
+    sat_var_idx   * order = imp_mat -> level_order;
+    unsigned char * dirty = calloc(imp_mat -> variable_count > 0 ?
+                                   imp_mat -> variable_count : 1, 1);
+    int             i;
+
+    for(i = 0; i < (int)total; i += 1) {
+        dirty[order[i]] = SAT_TRUE;
+    }
+
+    int progress = 1;
+
+    #pragma omp parallel num_threads(threads)
+    {
+        unsigned int level;
+
+        while(progress) {
+
+            // Every thread must have seen progress before it is reset.
+            #pragma omp barrier
+            #pragma omp single
+            progress = 0;
+
+            // Forward sweep, from the inputs to the outputs.
+            for(level = 0; level < count; level += 1) {
+                #pragma omp for schedule(dynamic, SAT_LEVEL_CHUNK)
+                for(i = start[level]; i < (int)start[level + 1]; i += 1) {
+                    if(sat_levels_revise_shared(imp_mat, dirty, order[i])) {
+                        __atomic_store_n(&progress, 1, __ATOMIC_RELAXED);
+                    }
+                }
+            }
+
+            // Reverse sweep, from the outputs back to the inputs.
+            for(level = count; level > 0; level -= 1) {
+                #pragma omp for schedule(dynamic, SAT_LEVEL_CHUNK)
+                for(i = start[level - 1]; i < (int)start[level]; i += 1) {
+                    if(sat_levels_revise_shared(imp_mat, dirty, order[i])) {
+                        __atomic_store_n(&progress, 1, __ATOMIC_RELAXED);
+                    }
+                }
+            }
+        }
+    }
+
+    free(dirty);
+    return !sat_any_domain_empty(imp_mat);
+#else
+    return sat_solve(imp_mat);
+#endif
+}
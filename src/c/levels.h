@@ -0,0 +1,71 @@
+
+#include "imp-matrix.h"
+
+#ifndef H_LEVELS
+#define H_LEVELS
+
+/*!
+@defgroup gr-levels Levelized Solver
+
+@brief Propagation by sweeping relations in topological order.
+
+@details Relations compiled from assignments form a DAG from the inputs to
+the assignees. Sorting them into levels once means a forward sweep can
+narrow every assignee in a single pass without a worklist. A reverse sweep
+then pushes narrowing back from assignees to operands. Sweeps repeat until
+nothing changes, reaching the same fixed point as sat_solve.
+
+Relations within a level never read each other's assignees, so they can
+also be revised in parallel by sat_solve_parallel.
+
+@addtogroup gr-levels
+@{
+*/
+
+
+/*!
+@brief Sort the relations of a matrix into topological levels.
+@details Fills in level_order, level_start and level_count of the matrix.
+Uses the fanout index, building it first if it is stale.
+@param [inout] imp_mat - The matrix to operate on.
+@returns SAT_TRUE if the relations are acyclic and the levels are valid.
+SAT_FALSE if there is a cycle, in which case levels_acyclic is cleared.
+*/
+t_sat_bool sat_build_levels(
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Solve the constraint problem using levelized forward and reverse
+sweeps.
+@details Gives exactly the same domains as sat_solve when the problem has
+no conflict. Falls back to sat_solve if the relations contain a cycle.
+Levels are built automatically if they are stale.
+@param [inout] imp_mat - The matrix to operate on.
+@returns True if the system is solvable.
+*/
+t_sat_bool sat_solve_levelized(
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Solve the constraint problem by sweeping levels in parallel.
+@details The relations within each level are revised in parallel, with a
+barrier between levels. Unlike sat_solve, propagation does not stop at the
+first empty domain but runs until nothing changes, so the final domains do
+not depend on how the work was split between threads. Falls back to
+sat_solve if the relations contain a cycle, or if built without OpenMP.
+@param [inout] imp_mat - The matrix to operate on.
+@param [in] threads - How many threads to use, or 0 for the OpenMP default.
+@returns True if the system is solvable.
+*/
+t_sat_bool sat_solve_parallel(
+    sat_imp_matrix * imp_mat,
+    unsigned int     threads
+);
+
+/*! @} */
+
+#endif
@@ -1,31 +1,156 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include <sys/time.h>
 
+#include "sats.h"
 #include "sat-expression.h"
-#include "satsolver.h"
-#include "imp-matrix.h"
-#include "sat-expression-parser.h"
-#include "sat-expression-scanner.h"
-
-extern FILE *       yyin;
+#include "batch.h"
+#include "serve.h"
+#include "compiled.h"
+#include "collapse.h"
+#include "fold.h"
+#include "cone.h"
+#include "components.h"
+#include "renumber.h"
 
 /*!
 @brief Prints command line usage options for the program.
 @param [in] command_line - The value of argv[0], used to launch the program.
 */
 void print_usage(char * command_line) {
-    printf("Usage: %s <assignments-file>\n\n", command_line);
+    printf("Usage: %s [options] <assignments-file>\n\n", command_line);
     printf("assignments-file - file path to list of boolean assignments\n\
                                to process.\n");
+    printf("--levelized      - solve by sweeping relations in topological\n\
+                               order rather than with a worklist.\n");
+    printf("--parallel       - as --levelized, but revise the relations in\n\
+                               each level in parallel.\n");
+    printf("--async          - solve with multi-threaded, work stealing\n\
+                               AC-3.\n");
+    printf("--components     - split the relations into connected\n\
+                               components and solve them in parallel.\n");
+    printf("--search         - after propagating, search for a satisfying\n\
+                               assignment and print it.\n");
+    printf("--fold           - fold constants and fixed variables through\n\
+                               the relations before solving, deleting\n\
+                               those whose value becomes known.\n");
+    printf("--cone           - before solving, delete every relation\n\
+                               outside the fan-in of the constrained\n\
+                               and expected variables. Cannot be used\n\
+                               with --search.\n");
+    printf("--collapse       - merge variables which are copies or\n\
+                               inverses of each other before solving.\n");
+    printf("--renumber       - renumber the variables so connected ones\n\
+                               are close together in memory before\n\
+                               solving.\n");
+    printf("--batch          - solve every file or directory given on the\n\
+                               command line, several at once, and print\n\
+                               one result record per file.\n");
+    printf("--compile        - parse the assignments file and write it\n\
+                               in compiled form to the -o file, which\n\
+                               can then be solved without parsing.\n");
+    printf("-o <path>        - the output file for --compile.\n");
+    printf("--serve          - answer queries about loaded circuits, one\n\
+                               request per line, read from stdin.\n");
+    printf("--socket <path>  - with --serve, listen for clients on a Unix\n\
+                               domain socket instead of stdin.\n");
+    printf("--threads <N>    - number of threads used by --parallel,\n\
+                               --async, --components and --batch.\n\
+                               Defaults to OMP_NUM_THREADS or the\n\
+                               number of cores.\n");
                              
     printf("\n");
 }
+
+
+/*!
+@brief Solve a batch of files and print one result record for each.
+@param [in] paths - The files and directories to solve.
+@param [in] count - The number of paths.
+@param [in] levelized - Solve with sat_solve_levelized rather than sat_solve.
+@param [in] search - Also decide satisfiability with sat_search.
+@param [in] threads - How many files to solve at once, or 0 for the default.
+@returns 0 if every file was solved and met its expectations, otherwise 1.
+*/
+int run_batch(
+    char         ** paths,
+    int             count,
+    t_sat_bool      levelized,
+    t_sat_bool      search,
+    unsigned int    threads
+){
+    sat_batch * batch = sat_new_batch();
+    int         i;
+
+    for(i = 0; i < count; i ++) {
+        if(!sat_batch_add_path(batch, paths[i])) {
+            printf("Error: Could not read directory '%s'\n", paths[i]);
+            sat_free_batch(batch);
+            return 1;
+        }
+    }
+
+    sat_solve_batch(batch, levelized, search, threads);
+
+    unsigned int failed = 0;
+    unsigned int ri;
+
+    for(ri = 0; ri < batch -> length; ri ++) {
+        sat_batch_result * result = &batch -> results[ri];
+
+        printf("%s: %s, variables: %u, empty domains: %u, expectations %s\n",
+               result -> path,
+               sat_batch_status_name(result -> status),
+               result -> variables,
+               result -> empty,
+               result -> expectations ? "met" : "not met");
+
+        if(result -> status == SAT_BATCH_SYNTAX_ERROR ||
+           result -> status == SAT_BATCH_UNREADABLE   ||
+           !result -> expectations) {
+            failed ++;
+        }
+    }
+
+    printf("Files: %u, Failed: %u\n", batch -> length, failed);
+
+    sat_free_batch(batch);
+    return failed ? 1 : 0;
+}
  
 
+/*!
+@brief Run the solver daemon until its input ends or a client shuts it
+down.
+@param [in] socket_path - Path of the Unix domain socket to listen on, or
+NULL to answer requests from stdin.
+@returns 0 on a clean shutdown, otherwise 1.
+*/
+int run_server(
+    char * socket_path
+){
+    sat_server * server = sat_new_server();
+    int          result = 0;
+
+    if(socket_path != NULL) {
+        result = sat_serve_socket(server, socket_path);
+        if(result) {
+            fprintf(stderr, "Error: Could not listen on '%s'\n",
+                    socket_path);
+        }
+    } else {
+        sat_serve_stream(server, stdin, stdout);
+    }
+
+    sat_free_server(server);
+    return result;
+}
+
+
 /*!
 @brief The Main entry point function for the wrapper program.
 @param [in] argc - Number of input arguments
@@ -35,107 +160,291 @@ void print_usage(char * command_line) {
 */
 int main (int argc, char ** argv) 
 {
-    printf("----------[SAT-Solver]----------\n");
-  
     // Try to open the file containing the list of assignments we will
     // parse.
 
-    if(argc == 2)
-    {
-        char * input_file = argv[1];
-        if(input_file[0] == '-') {
-            yyset_in(stdin);
-        } else {
-            printf("Parsing '%s' ", input_file); fflush(stdout);
-            yyset_in(fopen(input_file,"r"));
+    char     * input_file = NULL;
+    t_sat_bool levelized  = SAT_FALSE;
+    t_sat_bool parallel   = SAT_FALSE;
+    t_sat_bool async      = SAT_FALSE;
+    t_sat_bool components = SAT_FALSE;
+    t_sat_bool search     = SAT_FALSE;
+    t_sat_bool collapse   = SAT_FALSE;
+    t_sat_bool fold       = SAT_FALSE;
+    t_sat_bool cone       = SAT_FALSE;
+    t_sat_bool renumber   = SAT_FALSE;
+    t_sat_bool batch      = SAT_FALSE;
+    t_sat_bool serve      = SAT_FALSE;
+    t_sat_bool compile    = SAT_FALSE;
+    char     * socket_path = NULL;
+    char     * output_file = NULL;
+    int        threads    = 0;
+    char    ** paths      = calloc(argc, sizeof(char*));
+    int        path_count = 0;
+    int        ai;
 
-            if(yyin == NULL) {
-                printf("Error: Could not open input file '%s'\n", input_file);
+    for(ai = 1; ai < argc; ai ++)
+    {
+        if(strcmp(argv[ai], "--levelized") == 0) {
+            levelized = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--parallel") == 0) {
+            parallel = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--async") == 0) {
+            async = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--components") == 0) {
+            components = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--search") == 0) {
+            search = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--fold") == 0) {
+            fold = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--cone") == 0) {
+            cone = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--renumber") == 0) {
+            renumber = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--collapse") == 0) {
+            collapse = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--batch") == 0) {
+            batch = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--serve") == 0) {
+            serve = SAT_TRUE;
+        } else if(strcmp(argv[ai], "--compile") == 0) {
+            compile = SAT_TRUE;
+        } else if(strcmp(argv[ai], "-o") == 0 && ai + 1 < argc) {
+            output_file = argv[++ ai];
+        } else if(strcmp(argv[ai], "--socket") == 0 && ai + 1 < argc) {
+            socket_path = argv[++ ai];
+        } else if(strcmp(argv[ai], "--threads") == 0 && ai + 1 < argc) {
+            threads = atoi(argv[++ ai]);
+            if(threads < 1) {
+                print_usage(argv[0]);
+                free(paths);
                 return 1;
             }
+        } else if(argv[ai][0] == '-' && argv[ai][1] == '-') {
+            print_usage(argv[0]);
+            free(paths);
+            return 1;
+        } else {
+            input_file = argv[ai];
+            paths[path_count ++] = argv[ai];
+        }
+    }
+
+    if(serve) {
+        // Replies go to stdout, so print nothing else there.
+        free(paths);
+        return run_server(socket_path);
+    }
+
+    printf("----------[SAT-Solver]----------\n");
+
+    if(batch) {
+        int result = run_batch(paths, path_count, levelized, search, threads);
+        free(paths);
+        return result;
+    }
+
+    free(paths);
+
+    if((compile && output_file == NULL) || (cone && search)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // The parser adds each assignment to the context's matrix as soon as it
+    // has been read, so the matrix grows as we go.
+    sat_context * ctx         = sat_new_context();
+    int           load_result = SAT_LOAD_OK;
+
+    if(input_file != NULL && input_file[0] != '-')
+    {
+        // Compiled files are recognised and mapped rather than parsed.
+        printf("Parsing '%s' ", input_file); fflush(stdout);
+        load_result = sat_load_file(ctx, input_file);
+
+        if(load_result == SAT_LOAD_UNREADABLE) {
+            printf("Error: Could not open input file '%s'\n", input_file);
+            sat_free_context(ctx);
+            return 1;
         }
     }
     else
     {
         // Read input from stdin
-        yyset_in(stdin);
+        load_result = sat_parse_file(ctx, stdin) ? SAT_LOAD_INVALID
+                                                 : SAT_LOAD_OK;
     }
 
-    // Run the parser.
-    if(yyparse()) {
+    if(load_result != SAT_LOAD_OK) {
         printf("Syntax Error\n");
-        yylex_destroy();
+        sat_free_context(ctx);
         return 1;
     } else {
         printf("[DONE]\n");
     }
 
-    // We are finished with the input now.
-    fclose(yyin);
-    yylex_destroy();
+    sat_imp_matrix * imp_matrix = sat_get_imp_matrix(ctx);
+
+    if(compile) {
+        int result = sat_write_compiled(ctx, output_file);
+        if(result) {
+            printf("Error: Could not write '%s'\n", output_file);
+        } else {
+            printf("Compiled %u variables to '%s'\n",
+                   sat_get_variable_count(ctx), output_file);
+        }
+        sat_free_context(ctx);
+        return result;
+    }
 
-    // How many variables are there?
-    unsigned int variable_count = sat_get_variable_count();
+    // How many variables are there? Some may only appear in expectations,
+    // but parsing has already made sure the matrix covers them all.
+    unsigned int variable_count = sat_get_variable_count(ctx);
     printf("Total Variables: %d\n", variable_count);
 
-    // Build the implication matrix
-    sat_imp_matrix * imp_matrix = sat_new_imp_matrix(variable_count);
+    arena * front_end = sat_get_front_end_arena(ctx);
+    arena * ast       = sat_get_ast_arena(ctx);
+    printf("Parser Allocations: %lu (%lu bytes peak)\n",
+           (unsigned long)(front_end -> allocations + ast -> allocations),
+           (unsigned long)(front_end -> peak_bytes  + ast -> peak_bytes ));
+    printf("Merged Sub-expressions: %u\n", sat_get_merged_node_count(ctx));
 
-    
-    // Add all of the assignments to the implication matrix.
-    printf("Adding assignments to matrix... "); fflush(stdout);
+    if(fold) {
+        sat_fold_stats folded;
+        sat_fold_constants(imp_matrix, &folded);
+        printf("Folded Relations: %u, Reduced to Copies: %u\n",
+               folded.folded, folded.reduced);
+    }
 
-    sat_assignment * walker = yy_assignments;
-    while(walker != NULL) {
-        sat_add_assignment_to_imp_matrix(imp_matrix,walker);
-        walker = walker -> next;
+    // Folding leaves copies behind, so it goes first. Pruning goes last, so
+    // it sees the relations collapsing turns back on themselves.
+    sat_collapse * classes = NULL;
+    if(collapse) {
+        classes = sat_collapse_equivalences(imp_matrix);
+        printf("Collapsed Variables: %u\n", classes -> collapsed);
+    }
+
+    if(cone) {
+        sat_var_idx  * roots      = calloc(variable_count > 0 ?
+                                           variable_count : 1,
+                                           sizeof(sat_var_idx));
+        unsigned int   root_count = 0;
+        sat_var_idx    ri;
+        sat_cone_stats pruned;
+
+        for(ri = 0; ri < variable_count; ri ++) {
+            if(!sat_variable_has_expectation(ctx, ri)) continue;
+
+            // A merged variable is solved through its representative.
+            roots[root_count ++] = classes != NULL ?
+                                   classes -> representative[ri] : ri;
+        }
+
+        sat_prune_to_cone(imp_matrix, roots, root_count, &pruned);
+        printf("Pruned Variables: %u, Pruned Relations: %u\n",
+               pruned.variables, pruned.relations);
+        free(roots);
+    }
+
+    // Renumbering goes after every pass which deletes relations, so the
+    // new order only has to keep what is left close together.
+    sat_renumbering * order = NULL;
+    if(renumber) {
+        order = sat_renumber_variables(imp_matrix);
+    }
+
+    sat_components * parts = NULL;
+    if(components) {
+        parts = sat_find_components(imp_matrix);
+        printf("Components: %u, Largest Component: %u\n",
+               parts -> component_count, parts -> largest);
     }
-    printf("[DONE]\n");
 
     // Run the sat solver.
     printf("Running SAT Solver...           "); fflush(stdout);
-    sat_solve(imp_matrix);
+    if(parts != NULL) {
+        sat_solve_components(imp_matrix, parts, threads);
+        sat_free_components(parts);
+    } else if(async) {
+        sat_solve_async(imp_matrix, threads);
+    } else if(parallel) {
+        sat_solve_parallel(imp_matrix, threads);
+    } else if(levelized) {
+        sat_solve_levelized(imp_matrix);
+    } else {
+        sat_solve(imp_matrix);
+    }
     printf("[DONE]\n");
 
+    if(order != NULL) {
+        sat_restore_numbering(order, imp_matrix);
+        sat_free_renumbering(order);
+    }
+
+    if(classes != NULL) {
+        sat_expand_equivalences(classes, imp_matrix);
+    }
+
     // Check if we met our expectations of variable domains.
     t_sat_bool met_expectations = SAT_TRUE;
     sat_var_idx vi;
 
-    unsigned int empty_variables = 0;
-    unsigned int unsat_variables = 0;
-
     for(vi = 0; vi < variable_count; vi ++)
     {
-        sat_expression_variable * var = sat_get_variable_from_id(vi);
-        met_expectations &= sat_check_expectations(var,imp_matrix,SAT_TRUE);
-
-        if(sat_value_in_domain(imp_matrix, vi, SAT_TRUE)) {
-            // Do Nothing
-        } else {
-            printf("%s Cannot be satisfied.\n", var -> name);
-            unsat_variables += 1;
+        met_expectations &= sat_variable_expectations_met(ctx, vi, SAT_TRUE);
 
-            if(sat_value_in_domain(imp_matrix, vi, SAT_FALSE) == SAT_FALSE){
-                empty_variables += 1;
-            }
+        if(!sat_value_in_domain(imp_matrix, vi, SAT_TRUE)) {
+            printf("%s Cannot be satisfied.\n",
+                   sat_get_variable_name(ctx, vi));
         }
     }
+
+    unsigned int unsat_variables = sat_count_excluded(imp_matrix, SAT_TRUE);
+    unsigned int empty_variables = sat_count_empty_domains(imp_matrix);
     
     printf("Unsatisfiable Variables:     %d\n", unsat_variables);
     printf("Variables with empty domain: %d\n", empty_variables);
 
+    if(search) {
+        sat_search_stats stats;
 
-    // ---- End of program. Clean up. --------
+        printf("Running Search...               "); fflush(stdout);
+        t_sat_bool satisfiable = sat_search(imp_matrix, &stats);
+        printf("[DONE]\n");
+
+        if(satisfiable && !sat_check_model(imp_matrix)) {
+            printf("Model Does Not Satisfy Every Relation!\n");
+            met_expectations = SAT_FALSE;
+        }
 
+        if(classes != NULL) {
+            sat_expand_equivalences(classes, imp_matrix);
+        }
 
-    // Free the assignment tree.
-    sat_free_assignment(yy_assignments, 1);
+        printf("Decisions: %lu, Conflicts: %lu, Learnt: %lu, Restarts: %lu\n",
+               stats.decisions, stats.conflicts, stats.learnt,
+               stats.restarts);
 
-    // Free the implication matrix
-    sat_free_imp_matrix(imp_matrix);
+        if(satisfiable) {
+            printf("Satisfiable\n");
+            for(vi = 0; vi < variable_count; vi ++) {
+                printf("%s = %d\n", sat_get_variable_name(ctx, vi),
+                       sat_value_in_domain(imp_matrix, vi, SAT_TRUE));
+            }
+        } else {
+            printf("Unsatisfiable\n");
+        }
+    }
 
-    // Free the expression variable list.
-    sat_free_expression_variable(yy_sat_variables,1);
+
+    // ---- End of program. Clean up. --------
+
+
+    // Free the implication matrix, expression variables and parser state.
+    if(classes != NULL) {
+        sat_free_collapse(classes);
+    }
+    sat_free_context(ctx);
     
     if(met_expectations) {
         printf("Expectations Met!\n");
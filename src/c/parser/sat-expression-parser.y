@@ -1,22 +1,34 @@
 
 %defines
 %verbose
+%define api.pure full
+%define api.prefix {satyy}
 
-%{
+%code requires {
+
+#include "sat-expression.h"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void * yyscan_t;
+#endif
+
+}
+
+%code {
 
 #define YYERROR_VERBOSE 1
 
 #include <stdio.h>
 #include <math.h>
 
-#include "sat-expression.h"
-
-int  yyerror          (const char          * s    );
+int satyylex (SATYYSTYPE * lvalp, yyscan_t scanner);
+int satyyerror(sat_context * ctx, yyscan_t scanner, const char * s);
 
-//! @note Declared in sat-expression.h
-extern sat_assignment * yy_assignments;
+}
 
-%}
+%parse-param {sat_context * ctx} {yyscan_t scanner}
+%lex-param   {yyscan_t scanner}
 
 /* BISON Declarations */
 %token TOK_ZERO
@@ -54,40 +66,28 @@ extern sat_assignment * yy_assignments;
 %type <expr>    expression_binary
 %type <expr>    expression
 %type <var>     variable
-%type <assign>  assignment
-%type <assign>  input_assignments
-%type <assign>  start
 
 %union {
     char * vid;
     int    integer;
     sat_expression_node     * expr;
     sat_expression_variable * var;
-    sat_assignment          * assign;
 }
 
 /* Grammar follows */
 %%
 
-start : input_assignments unary_constraints expectations TOK_END {
-    $$ = $1;
-    yy_assignments = $$;
-}
+start : input_assignments unary_constraints expectations TOK_END
 
-input_assignments:    /* empty string */ {
-    $$ = NULL;
-}
-| input_assignments assignment {
-    $$ = $2;
-    if ($1 != NULL)
-    {
-        $$ -> next = $1;
-    }
-}
+input_assignments:    /* empty string */
+| input_assignments assignment
 ;
 
 assignment : variable TOK_ASSIGN expression {
-    $$ = sat_new_assignment($1,$3);
+    // Compile the assignment straight away, then throw its AST away.
+    sat_add_assignment_to_imp_matrix(ctx -> imp_matrix,
+                                     sat_new_assignment(ctx,$1,$3));
+    sat_release_ast(ctx);
 }
 ;
 
@@ -102,42 +102,50 @@ expression :
     $$ = $1;
     }
 |   variable {
-    $$ = sat_new_leaf_expression_node($1);
+    $$ = sat_new_leaf_expression_node(ctx,$1);
+    }
+|   TOK_ZERO {
+    $$ = sat_new_leaf_expression_node(ctx,
+             sat_get_constant_variable(ctx, SAT_FALSE));
+    }
+|   TOK_ONE {
+    $$ = sat_new_leaf_expression_node(ctx,
+             sat_get_constant_variable(ctx, SAT_TRUE));
     }
 ;
 
 expression_binary : 
     expression TOK_OP_AND expression{
-    $$ = sat_new_binary_expression_node($1,$3,SAT_AND);
+    $$ = sat_new_binary_expression_node(ctx,$1,$3,SAT_AND);
     }
 |   expression TOK_OP_NAND expression{
-    $$ = sat_new_binary_expression_node($1,$3,SAT_NAND);
+    $$ = sat_new_binary_expression_node(ctx,$1,$3,SAT_NAND);
     }
 |  expression TOK_OP_OR  expression{
-    $$ = sat_new_binary_expression_node($1,$3,SAT_OR );
+    $$ = sat_new_binary_expression_node(ctx,$1,$3,SAT_OR );
     }
 |  expression TOK_OP_NOR  expression{
-    $$ = sat_new_binary_expression_node($1,$3,SAT_NOR);
+    $$ = sat_new_binary_expression_node(ctx,$1,$3,SAT_NOR);
     }
 |  expression TOK_OP_XOR expression{
-    $$ = sat_new_binary_expression_node($1,$3,SAT_XOR);
+    $$ = sat_new_binary_expression_node(ctx,$1,$3,SAT_XOR);
     }
 |  expression TOK_OP_NXOR expression{
-    $$ = sat_new_binary_expression_node($1,$3,SAT_NXOR);
+    $$ = sat_new_binary_expression_node(ctx,$1,$3,SAT_NXOR);
     }
 |  expression TOK_OP_IMP expression{
-    $$ = sat_new_binary_expression_node($1,$3,SAT_IMP );
+    $$ = sat_new_binary_expression_node(ctx,$1,$3,SAT_IMP );
     }
 ;
 
 expression_unary :
     TOK_OP_NOT expression {
-    $$ = sat_new_unary_expression_node($2, SAT_NOT); 
+    $$ = sat_new_unary_expression_node(ctx,$2, SAT_NOT);
     }
 ;
 
 variable : TOK_ID {
-    $$ = sat_new_named_expression_variable($1);
+    $$ = sat_new_named_expression_variable(ctx,$1);
 };
 
 unary_constraints : 
@@ -148,16 +156,20 @@ unary_constraint  :
     variable TOK_OP_EQ TOK_ZERO {
         $1 -> can_be_0 = SAT_TRUE;
         $1 -> can_be_1 = SAT_FALSE;
+        sat_apply_unary_constraints(ctx -> imp_matrix, $1);
     }
 |   variable TOK_OP_EQ TOK_ONE  {
         $1 -> can_be_0 = SAT_FALSE;
         $1 -> can_be_1 = SAT_TRUE;
+        sat_apply_unary_constraints(ctx -> imp_matrix, $1);
     }
 |   variable TOK_OP_NE TOK_ZERO {
         $1 -> can_be_0 = SAT_FALSE;
+        sat_apply_unary_constraints(ctx -> imp_matrix, $1);
     }
 |   variable TOK_OP_NE TOK_ONE {
         $1 -> can_be_1 = SAT_FALSE;
+        sat_apply_unary_constraints(ctx -> imp_matrix, $1);
     }
 ;
 
@@ -167,25 +179,25 @@ expectations:
 
 domain_expectation:
     TOK_EXPECT TOK_DOMAIN TOK_ID TOK_OP_EQ TOK_OP TOK_CP {
-        sat_expression_variable * vv = sat_new_named_expression_variable($3);
+        sat_expression_variable * vv = sat_new_named_expression_variable(ctx,$3);
         vv -> check_domain = SAT_TRUE;
         vv -> expect_0     = SAT_FALSE;
         vv -> expect_1     = SAT_FALSE;
 }
 |   TOK_EXPECT TOK_DOMAIN TOK_ID TOK_OP_EQ TOK_OP TOK_ONE  TOK_CP{
-        sat_expression_variable * vv = sat_new_named_expression_variable($3);
+        sat_expression_variable * vv = sat_new_named_expression_variable(ctx,$3);
         vv -> check_domain = SAT_TRUE;
         vv -> expect_0     = SAT_FALSE;
         vv -> expect_1     = SAT_TRUE;
 }
 |   TOK_EXPECT TOK_DOMAIN TOK_ID TOK_OP_EQ TOK_OP TOK_ZERO TOK_CP{
-        sat_expression_variable * vv = sat_new_named_expression_variable($3);
+        sat_expression_variable * vv = sat_new_named_expression_variable(ctx,$3);
         vv -> check_domain = SAT_TRUE;
         vv -> expect_0     = SAT_TRUE;
         vv -> expect_1     = SAT_FALSE;
 }
 |   TOK_EXPECT TOK_DOMAIN TOK_ID TOK_OP_EQ TOK_OP TOK_ZERO TOK_ONE TOK_CP{
-        sat_expression_variable * vv = sat_new_named_expression_variable($3);
+        sat_expression_variable * vv = sat_new_named_expression_variable(ctx,$3);
         vv -> check_domain = SAT_TRUE;
         vv -> expect_0     = SAT_TRUE;
         vv -> expect_1     = SAT_TRUE;
@@ -193,7 +205,7 @@ domain_expectation:
 
 %%
 
-int yyerror (const char *s)
+int satyyerror (sat_context * ctx, yyscan_t scanner, const char *s)
 {
       printf ("[PARSE ERROR] %s\n", s);
       return 1;
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "renumber.h"
+
+/*!
+@brief A variable waiting to be numbered, with its degree, for sorting.
+*/
+typedef struct sat_rcm_entry_t {
+    unsigned int degree;   //!< Neighbours of the variable.
+    sat_var_idx  variable; //!< The variable.
+} sat_rcm_entry;
+
+
+//! qsort comparison function ordering variables by increasing degree.
+static int sat_compare_rcm_entries(const void * a, const void * b)
+{
+    const sat_rcm_entry * ea = a;
+    const sat_rcm_entry * eb = b;
+
+    if(ea -> degree != eb -> degree) {
+        return ea -> degree < eb -> degree ? -1 : 1;
+    }
+    return ea -> variable < eb -> variable ? -1 : 1;
+}
+
+
+/*!
+@brief Sort part of the breadth first order by increasing degree.
+@details Almost every variable has only a few new neighbours, which are
+sorted in place. Only wide fanouts go through qsort.
+@param [inout] order - The variables to sort.
+@param [in] count - How many there are.
+@param [in] degree - The number of neighbours of each variable.
+@param [inout] scratch - Space for count entries.
+*/
+static void sat_rcm_sort(
+    sat_var_idx        * order,
+    unsigned int         count,
+    const unsigned int * degree,
+    sat_rcm_entry      * scratch
+){
+    unsigned int i, j;
+
+    for(i = 0; i < count; i += 1) {
+        scratch[i].variable = order[i];
+        scratch[i].degree   = degree[order[i]];
+    }
+
+    if(count > 16) {
+        qsort(scratch, count, sizeof(sat_rcm_entry), sat_compare_rcm_entries);
+    } else {
+        for(i = 1; i < count; i += 1) {
+            sat_rcm_entry e = scratch[i];
+
+            for(j = i; j > 0 && sat_compare_rcm_entries(&e, &scratch[j-1]) < 0;
+                j -= 1) {
+                scratch[j] = scratch[j - 1];
+            }
+            scratch[j] = e;
+        }
+    }
+
+    for(i = 0; i < count; i += 1) {
+        order[i] = scratch[i].variable;
+    }
+}
+
+
+/*!
+@brief Add a variable to the breadth first order, if it is not already in
+it.
+*/
+static void sat_rcm_visit(
+    sat_var_idx   * order,
+    unsigned int  * tail,
+    unsigned char * visited,
+    sat_var_idx     variable
+){
+    if(!visited[variable]) {
+        visited[variable] = SAT_TRUE;
+        order[(*tail) ++] = variable;
+    }
+}
+
+
+/*!
+@brief Move every variable of a matrix to a new index.
+@param [inout] imp_mat - The matrix to rewrite.
+@param [in] to - The new index of each variable.
+*/
+static void sat_permute_matrix(
+    sat_imp_matrix    * imp_mat,
+    const sat_var_idx * to
+){
+    unsigned int   n         = imp_mat -> variable_count;
+    sat_relation * relations = malloc((n > 0 ? n : 1) * sizeof(sat_relation));
+    t_sat_bool   * domains   = malloc(n > 0 ? n : 1);
+    sat_var_idx    v;
+
+    memcpy(relations, imp_mat -> relations, n * sizeof(sat_relation));
+
+    for(v = 0; v < n; v += 1) {
+        domains[v] = sat_get_domain_bits(imp_mat, v);
+    }
+
+    for(v = 0; v < n; v += 1) {
+        sat_relation r = relations[v];
+
+        if(r.op != SAT_INPUT) {
+            r.lhs = to[r.lhs];
+            r.rhs = to[r.rhs];
+        }
+
+        imp_mat -> relations[to[v]] = r;
+        sat_set_domain_bits(imp_mat, to[v], domains[v]);
+    }
+
+    free(relations);
+    free(domains);
+
+    imp_mat -> fanout_stale = SAT_TRUE;
+    imp_mat -> levels_stale = SAT_TRUE;
+}
+
+
+/*!
+@brief Renumber the variables of a matrix by reverse Cuthill-McKee.
+@details The neighbours of a variable are the operands of its relation and
+the relations which read it, so the fanout index serves as the graph and
+nothing else needs building. Walks start at unvisited variables taken in
+order of increasing degree, so each connected part starts from one of its
+least connected variables.
+@param [inout] imp_mat - The matrix to renumber.
+@returns The permutation, to be freed with sat_free_renumbering.
+*/
+sat_renumbering * sat_renumber_variables(
+    sat_imp_matrix * imp_mat
+){
+    assert(imp_mat != NULL);
+
+    if(imp_mat -> fanout_stale) {
+        sat_build_fanout(imp_mat);
+    }
+
+    unsigned int   n          = imp_mat -> variable_count;
+    unsigned int * degree     = malloc((n > 0 ? n : 1) * sizeof(unsigned int));
+    unsigned int   max_degree = 0;
+    sat_var_idx    v;
+    unsigned int   i;
+
+    for(v = 0; v < n; v += 1) {
+        sat_relation * r = &imp_mat -> relations[v];
+
+        degree[v] = imp_mat -> fanout_start[v + 1] -
+                    imp_mat -> fanout_start[v];
+
+        if(r -> op != SAT_INPUT) {
+            degree[v] += (r -> lhs != v) +
+                         (r -> rhs != v && r -> rhs != r -> lhs);
+        }
+        if(degree[v] > max_degree) {
+            max_degree = degree[v];
+        }
+    }
+
+    // Counting sort of the variables by degree, giving the order in which
+    // walks are started.
+    sat_var_idx  * by_degree = malloc((n > 0 ? n : 1) * sizeof(sat_var_idx));
+    unsigned int * bucket    = calloc(max_degree + 2, sizeof(unsigned int));
+
+    for(v = 0; v < n; v += 1) {
+        bucket[degree[v] + 1] += 1;
+    }
+    for(i = 0; i <= max_degree; i += 1) {
+        bucket[i + 1] += bucket[i];
+    }
+    for(v = 0; v < n; v += 1) {
+        by_degree[bucket[degree[v]] ++] = v;
+    }
+    free(bucket);
+
+    // The breadth first order is built in place, and is its own queue.
+    sat_var_idx   * order   = malloc((n > 0 ? n : 1) * sizeof(sat_var_idx));
+    unsigned char * visited = calloc(n > 0 ? n : 1, 1);
+    sat_rcm_entry * scratch = malloc((max_degree > 0 ? max_degree : 1) *
+                                     sizeof(sat_rcm_entry));
+    unsigned int    head    = 0;
+    unsigned int    tail    = 0;
+
+    for(i = 0; i < n; i += 1) {
+        sat_rcm_visit(order, &tail, visited, by_degree[i]);
+
+        while(head < tail) {
+            sat_var_idx    u     = order[head ++];
+            sat_relation * r     = &imp_mat -> relations[u];
+            unsigned int   first = tail;
+            unsigned int   f;
+
+            if(r -> op != SAT_INPUT) {
+                sat_rcm_visit(order, &tail, visited, r -> lhs);
+                sat_rcm_visit(order, &tail, visited, r -> rhs);
+            }
+
+            for(f = imp_mat -> fanout_start[u];
+                f < imp_mat -> fanout_start[u + 1]; f += 1) {
+                sat_rcm_visit(order, &tail, visited, imp_mat -> fanout[f]);
+            }
+
+            sat_rcm_sort(order + first, tail - first, degree, scratch);
+        }
+    }
+
+    free(scratch);
+    free(visited);
+    free(by_degree);
+    free(degree);
+
+    sat_renumbering * result = calloc(1, sizeof(sat_renumbering));
+
+    result -> variable_count = n;
+    result -> new_index      = malloc((n > 0 ? n : 1) * sizeof(sat_var_idx));
+    result -> old_index      = order;
+
+    // Reversing the order is what makes this reverse Cuthill-McKee.
+    for(i = 0; i < n / 2; i += 1) {
+        sat_var_idx t    = order[i];
+        order[i]         = order[n - 1 - i];
+        order[n - 1 - i] = t;
+    }
+    for(i = 0; i < n; i += 1) {
+        result -> new_index[order[i]] = i;
+    }
+
+    sat_permute_matrix(imp_mat, result -> new_index);
+
+    return result;
+}
+
+
+/*!
+@brief Return a renumbered matrix to its original numbering.
+@param [in] renumbering - The permutation applied to the matrix.
+@param [inout] imp_mat - The matrix passed to sat_renumber_variables.
+*/
+void sat_restore_numbering(
+    sat_renumbering * renumbering,
+    sat_imp_matrix  * imp_mat
+){
+    assert(renumbering != NULL);
+    assert(imp_mat != NULL);
+    assert(renumbering -> variable_count == imp_mat -> variable_count);
+
+    sat_permute_matrix(imp_mat, renumbering -> old_index);
+}
+
+
+/*!
+@brief Free the permutation found by sat_renumber_variables.
+@param [in] tofree - The permutation to free.
+*/
+void sat_free_renumbering(
+    sat_renumbering * tofree
+){
+    if(tofree == NULL) {
+        return;
+    }
+
+    free(tofree -> new_index);
+    free(tofree -> old_index);
+    free(tofree);
+}
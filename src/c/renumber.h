@@ -0,0 +1,78 @@
+#include "imp-matrix.h"
+
+#ifndef H_RENUMBER
+#define H_RENUMBER
+
+/*!
+@defgroup gr-renumber Variable Renumbering
+
+@brief Give connected variables nearby indexes, so revising a relation
+touches fewer cache lines.
+
+@details Variables are numbered in the order the parser reduces them, and a
+netlist is rarely written in an order which keeps the operands of a gate
+near the gate. Revising a relation then reads its record and three domains
+from distant parts of memory, and the fanout of each variable points all
+over the matrix.
+
+sat_renumber_variables orders the variables by reverse Cuthill-McKee. Each
+connected part of the relation graph is walked breadth first, starting from
+a variable with the fewest neighbours and visiting the neighbours of each
+variable in order of how many neighbours they have. Reversing that order
+keeps the indexes of the participants of each relation close together. The
+matrix is then rewritten in the new numbering, and sat_restore_numbering
+puts it back once it has been solved, so the names and expectations of each
+variable can be checked as usual.
+
+@addtogroup gr-renumber
+@{
+*/
+
+/*!
+@brief The permutation applied by sat_renumber_variables.
+*/
+typedef struct sat_renumbering_t {
+    unsigned int    variable_count; //!< Variables in the matrix.
+    sat_var_idx   * new_index;      //!< New index of each original variable.
+    sat_var_idx   * old_index;      //!< Original index of each new variable.
+} sat_renumbering;
+
+
+/*!
+@brief Renumber the variables of a matrix by reverse Cuthill-McKee.
+@details Must be called before solving, once all relations have been added.
+The solved domains are the same as without renumbering, once the matrix is
+restored, when the problem has no conflict. When it has one, the conflict
+is still reported, but the solver may stop at a different empty domain.
+@param [inout] imp_mat - The matrix to renumber.
+@returns The permutation, to be freed with sat_free_renumbering.
+*/
+sat_renumbering * sat_renumber_variables(
+    sat_imp_matrix * imp_mat
+);
+
+
+/*!
+@brief Return a renumbered matrix to its original numbering.
+@details Call after each solve, or after sat_search, before reading the
+domains of the matrix by their original indexes.
+@param [in] renumbering - The permutation applied to the matrix.
+@param [inout] imp_mat - The matrix passed to sat_renumber_variables.
+*/
+void sat_restore_numbering(
+    sat_renumbering * renumbering,
+    sat_imp_matrix  * imp_mat
+);
+
+
+/*!
+@brief Free the permutation found by sat_renumber_variables.
+@param [in] tofree - The permutation to free.
+*/
+void sat_free_renumbering(
+    sat_renumbering * tofree
+);
+
+/*! @} */
+
+#endif
@@ -7,44 +7,84 @@
 
 #include "sat-expression.h"
 
-//! Incremented every time we declare a new ID.
-unsigned int yy_id_counter = 0;
+//! Size of the blocks the front end arena allocates objects from.
+#define SAT_ARENA_BLOCK_SIZE (1 << 20)
+
+//! Size of the blocks the AST arena allocates nodes from.
+#define SAT_AST_ARENA_BLOCK_SIZE (1 << 16)
+
+/*!
+@brief Returns the arena which owns all expression variables and names.
+@details It is created on first use and released by sat_free_context.
+@param [in] ctx - The context to look in.
+@returns A pointer to the front end arena.
+*/
+arena * sat_get_front_end_arena(
+    sat_context * ctx
+){
+    if(ctx -> arena == NULL) {
+        ctx -> arena = arena_new(SAT_ARENA_BLOCK_SIZE);
+    }
+    return ctx -> arena;
+}
+
+
+/*!
+@brief Returns the arena which owns expression nodes and assignments.
+@details It is created on first use, emptied by sat_release_ast and
+released by sat_free_context.
+@param [in] ctx - The context to look in.
+@returns A pointer to the AST arena.
+*/
+arena * sat_get_ast_arena(
+    sat_context * ctx
+){
+    if(ctx -> ast_arena == NULL) {
+        ctx -> ast_arena = arena_new(SAT_AST_ARENA_BLOCK_SIZE);
+    }
+    return ctx -> ast_arena;
+}
+
 
 /*!
-@brief Returns the total number of leaf and intermediate variables in all
-parsed assignments.
-@returns unsigned integer.
+@brief Discard every expression node and assignment created so far.
+@details Expression variables are not affected.
+@param [inout] ctx - The context to release the AST of.
 */
-unsigned int sat_get_variable_count()
-{
-    return yy_id_counter;
+void sat_release_ast(
+    sat_context * ctx
+){
+    if(ctx -> ast_arena != NULL) {
+        arena_reset(ctx -> ast_arena);
+    }
 }
 
 
 /*!
 @brief Turns a number into a string to be used as an intermediate result
 expression variable name.
-@param [in] id - The number, usually the value of yy_id_counter;
+@param [inout] ctx - The context whose arena holds the name.
+@param [in] id - The number, usually the value of the context's id_counter.
 @returns a string with the number in the name and a prefix.
 */
-char * sat_expression_var_id_to_name(unsigned int id) {
-    
-    size_t len = 3 + (int)(ceil(log10(id))+2);
-
-    char * tr = calloc(len, sizeof(char));
+char * sat_expression_var_id_to_name(sat_context * ctx, unsigned int id) {
     
-    sprintf(tr, "_iv%d", id);
+    char buffer[16];
+    int  len = snprintf(buffer, sizeof(buffer), "_iv%u", id);
 
-    return tr;
+    return arena_strndup(sat_get_front_end_arena(ctx), buffer, len);
 }
 
 /*!
 @brief Create a new un-named SAT expression variable.
+@param [inout] ctx - The context to create the variable in.
 @returns A pointer to a newly created sat_expression_variable.
 */
-sat_expression_variable * sat_new_expression_variable( )
-{
-    sat_expression_variable * tr = calloc(1, sizeof(sat_expression_variable));
+sat_expression_variable * sat_new_expression_variable(
+    sat_context * ctx
+){
+    sat_expression_variable * tr = arena_alloc(sat_get_front_end_arena(ctx),
+                                               sizeof(sat_expression_variable));
 
     if(tr == NULL)
     {
@@ -52,7 +92,7 @@ sat_expression_variable * sat_new_expression_variable( )
     }
     else
     {
-        tr -> uid  = yy_id_counter ++;
+        tr -> uid  = ctx -> id_counter ++;
         tr -> name = NULL;
         tr -> can_be_0 = SAT_TRUE;
         tr -> can_be_1 = SAT_TRUE;
@@ -61,100 +101,254 @@ sat_expression_variable * sat_new_expression_variable( )
 }
 
 
+/*!
+@brief FNV-1a hash of a variable name.
+@param [in] name - The string to hash.
+@returns The hash value.
+*/
+static unsigned int sat_hash_name(
+    const char * name
+){
+    unsigned int h = 2166136261u;
+    while(*name) {
+        h ^= (unsigned char)(*name);
+        h *= 16777619u;
+        name ++;
+    }
+    return h;
+}
+
+
+/*!
+@brief Find the slot in the name table holding the variable with the
+supplied name, or the empty slot where it should be inserted.
+@param [in] ctx - The context whose name table to search.
+@param [in] name - The name to search for.
+@returns The index of a slot in the name table.
+@warning Assumes the table is allocated and never completely full.
+*/
+static unsigned int sat_find_name_slot(
+    sat_context * ctx,
+    const char  * name
+){
+    unsigned int mask = ctx -> name_table_size - 1;
+    unsigned int slot = sat_hash_name(name) & mask;
+
+    while(ctx -> name_table[slot] != NULL &&
+          strcmp(ctx -> name_table[slot] -> name, name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+
+/*!
+@brief Double the size of the name table (or create it) and re-insert all
+of the variables it holds.
+@param [inout] ctx - The context whose name table to grow.
+*/
+static void sat_grow_name_table(
+    sat_context * ctx
+){
+    sat_expression_variable ** old      = ctx -> name_table;
+    unsigned int               old_size = ctx -> name_table_size;
+
+    ctx -> name_table_size = old_size ? old_size * 2 : 64;
+    ctx -> name_table      = calloc(ctx -> name_table_size,
+                                    sizeof(sat_expression_variable*));
+
+    unsigned int i;
+    for(i = 0; i < old_size; i += 1) {
+        if(old[i] != NULL) {
+            ctx -> name_table[sat_find_name_slot(ctx, old[i] -> name)] =
+                old[i];
+        }
+    }
+
+    free(old);
+}
+
+
+/*!
+@brief Record a newly created variable in the uid indexed table.
+@param [inout] ctx - The context whose uid table to update.
+@param [in] var - The variable to record.
+*/
+static void sat_record_uid(
+    sat_context             * ctx,
+    sat_expression_variable * var
+){
+    if(var -> uid >= ctx -> uid_table_size) {
+
+        unsigned int new_size = ctx -> uid_table_size ?
+                                ctx -> uid_table_size : 64;
+        while(new_size <= var -> uid) {
+            new_size *= 2;
+        }
+
+        ctx -> uid_table = realloc(ctx -> uid_table, new_size *
+                                   sizeof(sat_expression_variable*));
+        memset(ctx -> uid_table + ctx -> uid_table_size, 0,
+               (new_size - ctx -> uid_table_size) *
+               sizeof(sat_expression_variable*));
+
+        ctx -> uid_table_size = new_size;
+    }
+
+    ctx -> uid_table[var -> uid] = var;
+}
+
+
+/*!
+@brief Returns a copy of a variable name which lives in the front end arena.
+@details If a variable with this name already exists, its name is returned
+rather than making a new copy, so repeated identifiers cost no memory.
+@param [inout] ctx - The context to intern the name in.
+@param [in] text - The name, which must be null terminated.
+@param [in] len  - Length of the name.
+@returns A pointer to the name in the front end arena.
+*/
+sat_var_name sat_intern_name(
+    sat_context * ctx,
+    const char  * text,
+    size_t        len
+){
+    if(ctx -> name_table_size > 0) {
+        unsigned int slot = sat_find_name_slot(ctx, text);
+        if(ctx -> name_table[slot] != NULL) {
+            return ctx -> name_table[slot] -> name;
+        }
+    }
+
+    return arena_strndup(sat_get_front_end_arena(ctx), text, len);
+}
+
+
 /*!
 @brief Create a new named SAT expression variable.
+@details If a variable with this name already exists it is returned instead.
+Lookup is a single hash table probe.
+@param [inout] ctx - The context to create the variable in.
 @param [in] name  - Friendly name
 @returns A pointer to a newly created sat_expression_variable.
 */
 sat_expression_variable * sat_new_named_expression_variable(
+    sat_context   * ctx,
     sat_var_name    name
 ){
+    // Keep the table at most half full so probe sequences stay short.
+    if(2 * (ctx -> name_table_used + 1) > ctx -> name_table_size) {
+        sat_grow_name_table(ctx);
+    }
+
     // Check if a variable with this name already exists.
-    sat_expression_variable * walker = yy_sat_variables;
+    unsigned int slot = sat_find_name_slot(ctx, name);
 
-    if(walker == NULL) {
+    if(ctx -> name_table[slot] != NULL) {
+        return ctx -> name_table[slot];
+    }
 
-        sat_expression_variable * tr = sat_new_expression_variable();
-        tr     -> name = name;
-        yy_sat_variables = tr;
+    sat_expression_variable * tr = sat_new_expression_variable(ctx);
+    tr -> name = name;
 
-        return tr;
+    ctx -> name_table[slot]  = tr;
+    ctx -> name_table_used  += 1;
+
+    sat_record_uid(ctx, tr);
+
+    if(ctx -> variables == NULL) {
+        ctx -> variables = tr;
+    } else {
+        ctx -> variables_tail -> next = tr;
     }
+    ctx -> variables_tail = tr;
+
+    return tr;
+}
 
-    while(walker != NULL) {
 
-        int result = strcmp(name, walker -> name);
+/*!
+@brief Returns the variable which stands for a constant in expressions.
+@param [inout] ctx - The context to look in.
+@param [in] value - The constant.
+@returns A pointer to the expression variable.
+*/
+sat_expression_variable * sat_get_constant_variable(
+    sat_context * ctx,
+    t_sat_bool    value
+){
+    value = value ? 1 : 0;
 
-        if(result == 0) {
-            
-            free(walker -> name);
-            walker -> name = name;
+    if(ctx -> constants[value] == NULL) {
+        const char              * name = value ? "_1" : "_0";
+        sat_expression_variable * var  = sat_new_named_expression_variable(
+            ctx, sat_intern_name(ctx, name, 2));
 
-            return walker;
+        var -> can_be_0 = !value;
+        var -> can_be_1 =  value;
 
-        } else if (walker -> next == NULL)  {
-            
-            sat_expression_variable * tr = sat_new_expression_variable();
-            walker -> next = tr;
-            tr     -> name = name;
-            return tr;
-        }
-        walker = walker -> next;
+        ctx -> constants[value] = var;
+    }
+
+    return ctx -> constants[value];
+}
+
+
+/*!
+@brief Find an existing variable by name, without creating it.
+@param [in] ctx - The context to look in.
+@param [in] name - The name to search for.
+@returns A pointer to the expression variable or NULL if no such variable
+exists.
+*/
+sat_expression_variable * sat_find_named_expression_variable(
+    sat_context * ctx,
+    const char  * name
+){
+    if(ctx -> name_table_size == 0) {
+        return NULL;
     }
-    assert(1==0);
+    return ctx -> name_table[sat_find_name_slot(ctx, name)];
 }
 
 
 /*!
 @brief Returns the variable associated with the supplied ID.
+@param [in] ctx - The context to look in.
 @param [in] id - The unique id of the variable.
 @returns A pointer to the expression variable or NULL if no such variable
 exists.
 */
 sat_expression_variable * sat_get_variable_from_id(
+    sat_context   * ctx,
     sat_var_idx     id
 ){
-    sat_expression_variable * walker = yy_sat_variables;
-
-    while(walker != NULL)
-    {
-        if(walker -> uid == id) {
-            return walker;
-        }
-
-        walker = walker -> next;
+    if(id >= ctx -> uid_table_size) {
+        return NULL;
     }
-
-    return NULL;
+    return ctx -> uid_table[id];
 }
 
 
 /*!
-@brief Free the memory taken up by an expression variable.
-@param [in] tofree    - Pointer to the variable to free.
-@param [in] freelist  - Should we recursively free the *next field?
-@note Also frees the memory allocated for the name field of tofree.
+@brief Returns the table of all named variables, indexed by uid.
+@details The table has sat_get_variable_count(ctx) valid entries and is kept up
+to date as variables are created, so it may move when new variables are
+added.
+@param [in] ctx - The context to look in.
+@returns A pointer to the first element of the table.
 */
-void sat_free_expression_variable (
-    sat_expression_variable    * tofree,
-    t_sat_bool                   freelist
+sat_expression_variable ** sat_get_variable_table(
+    sat_context * ctx
 ){
-    if(tofree != NULL)
-    {
-        if(freelist && tofree -> next != NULL) {
-            sat_free_expression_variable(tofree -> next, 1);
-        }
-
-        if(tofree -> name != NULL) {
-            free(tofree -> name);
-        }
-        free(tofree);
-    }
+    return ctx -> uid_table;
 }
 
 
 /*!
 @brief Create a new sat_expression_node object with a given type.
+@param [inout] ctx - The context to create the node in.
 @param [in] node_type - Is this a leaf node (for a variable) or expression node?
 @param [in] ir - Intermediate result of the expression node. If NULL, a new one 
                 will be created anyway.
@@ -162,10 +356,12 @@ void sat_free_expression_variable (
 memory allocation fails.
 */
 sat_expression_node * sat_new_expression_node (
+    sat_context               * ctx,
     sat_expression_node_type    node_type,
     sat_expression_variable   * ir
 ) {
-    sat_expression_node * tr = calloc(1, sizeof(sat_expression_node));
+    sat_expression_node * tr = arena_alloc(sat_get_ast_arena(ctx),
+                                           sizeof(sat_expression_node));
 
     if(tr == NULL)
     {
@@ -176,8 +372,9 @@ sat_expression_node * sat_new_expression_node (
         tr -> node_type = node_type;
         
         if(ir == NULL) {
-            char * varname = sat_expression_var_id_to_name(yy_id_counter+1);
-            tr -> ir = sat_new_named_expression_variable(varname);
+            char * varname = sat_expression_var_id_to_name(
+                                 ctx, ctx -> id_counter + 1);
+            tr -> ir = sat_new_named_expression_variable(ctx, varname);
         } else {
             tr -> ir = ir;
         }
@@ -189,53 +386,20 @@ sat_expression_node * sat_new_expression_node (
 }
 
 
-/*!
-@brief Free the memory taken up by an expression node.
-@details Recursively fees this expression node and all sub-expression nodes,
-but leaves the leaf and intermediate variables allocated for later use.
-@param [in] tofree    - Pointer to the expression node to free.
-*/
-void sat_free_expression_node(
-    sat_expression_node * tofree
-){
-    assert(tofree != NULL);
-
-    if(tofree -> node_type == SAT_EXPRESSION_LEAF) {
-
-        // Don't free anything more.
-
-    } else if (tofree -> node_type == SAT_EXPRESSION_NODE) {
-
-        if(tofree -> op_type == SAT_NOT) {
-
-            sat_free_expression_node(tofree -> node.unary_operands.rhs);
-
-        } else {
-
-            sat_free_expression_node(tofree -> node.binary_operands.lhs);
-            sat_free_expression_node(tofree -> node.binary_operands.rhs);
-
-        }
-
-    }
-    
-    free(tofree);
-
-}
-
-
-
 /*!
 @brief Create a new sat_expression_node object for a leaf variable.
+@param [inout] ctx - The context to create the node in.
 @param [in] variable - The leaf variable for the node.
 @returns A pointer to a newly created sat_expression_node or NULL if the
 memory allocation fails.
 */
 sat_expression_node * sat_new_leaf_expression_node (
+    sat_context             * ctx,
     sat_expression_variable * variable
 ) {
     assert(variable != NULL);
-    sat_expression_node * tr = sat_new_expression_node(SAT_EXPRESSION_LEAF,
+    sat_expression_node * tr = sat_new_expression_node(ctx,
+                                                       SAT_EXPRESSION_LEAF,
                                                        variable);
 
     if(tr == NULL)
@@ -251,8 +415,145 @@ sat_expression_node * sat_new_leaf_expression_node (
 }
 
 
+/*!
+@brief Hash of an operation on two variables.
+@param [in] op - The operation.
+@param [in] lhs - Uid of the left hand operand.
+@param [in] rhs - Uid of the right hand operand.
+@returns The hash value.
+*/
+static unsigned int sat_hash_structure(
+    sat_binary_op op,
+    sat_var_idx   lhs,
+    sat_var_idx   rhs
+){
+    unsigned int h = (unsigned int)op * 0x9E3779B1u;
+    h = (h ^ lhs) * 0x85EBCA6Bu;
+    h = (h ^ rhs) * 0xC2B2AE35u;
+    return h ^ (h >> 16);
+}
+
+
+/*!
+@brief Find the slot in the structure table holding an operation, or the
+empty slot where it should be inserted.
+@param [in] ctx - The context whose structure table to search.
+@param [in] op - The operation.
+@param [in] lhs - Uid of the left hand operand.
+@param [in] rhs - Uid of the right hand operand.
+@returns The index of a slot in the structure table.
+@warning Assumes the table is allocated and never completely full.
+*/
+static unsigned int sat_find_structure_slot(
+    sat_context   * ctx,
+    sat_binary_op   op,
+    sat_var_idx     lhs,
+    sat_var_idx     rhs
+){
+    unsigned int           mask = ctx -> structure_table_size - 1;
+    unsigned int           slot = sat_hash_structure(op, lhs, rhs) & mask;
+    sat_structural_entry * e    = &ctx -> structure_table[slot];
+
+    while(e -> result != NULL &&
+          (e -> op != op || e -> lhs != lhs || e -> rhs != rhs)) {
+        slot = (slot + 1) & mask;
+        e    = &ctx -> structure_table[slot];
+    }
+
+    return slot;
+}
+
+
+/*!
+@brief Double the size of the structure table (or create it) and re-insert
+all of the operations it holds.
+@param [inout] ctx - The context whose structure table to grow.
+*/
+static void sat_grow_structure_table(
+    sat_context * ctx
+){
+    sat_structural_entry * old      = ctx -> structure_table;
+    unsigned int           old_size = ctx -> structure_table_size;
+
+    ctx -> structure_table_size = old_size ? old_size * 2 : 64;
+    ctx -> structure_table      = calloc(ctx -> structure_table_size,
+                                         sizeof(sat_structural_entry));
+
+    unsigned int i;
+    for(i = 0; i < old_size; i += 1) {
+        if(old[i].result != NULL) {
+            ctx -> structure_table[sat_find_structure_slot(
+                ctx, old[i].op, old[i].lhs, old[i].rhs)] = old[i];
+        }
+    }
+
+    free(old);
+}
+
+
+/*!
+@brief Create an expression node for an operation, unless the same
+operation on the same operands has been seen before.
+@details Operands are compared by uid, and the operands of every operation
+but SAT_IMP are put in order first, so "a & b" and "b & a" are the same.
+A repeated operation gives a leaf node for the variable which already holds
+its result, so it shares that variable and its relation rather than adding
+new ones.
+@param [inout] ctx - The context to create the node in.
+@param [in] op_type - The operation.
+@param [in] lhs - Uid of the left hand operand.
+@param [in] rhs - Uid of the right hand operand.
+@returns A new operation node, whose operands the caller must fill in, or a
+leaf node. NULL if the memory allocation fails.
+*/
+static sat_expression_node * sat_new_hashed_expression_node(
+    sat_context   * ctx,
+    sat_binary_op   op_type,
+    sat_var_idx     lhs,
+    sat_var_idx     rhs
+){
+    if(op_type != SAT_IMP && rhs < lhs) {
+        sat_var_idx swap = lhs;
+        lhs = rhs;
+        rhs = swap;
+    }
+
+    // Keep the table at most half full so probe sequences stay short.
+    if(2 * (ctx -> structure_table_used + 1) > ctx -> structure_table_size) {
+        sat_grow_structure_table(ctx);
+    }
+
+    unsigned int           slot  = sat_find_structure_slot(ctx, op_type,
+                                                           lhs, rhs);
+    sat_structural_entry * entry = &ctx -> structure_table[slot];
+
+    if(entry -> result != NULL) {
+        ctx -> merged_nodes += 1;
+        return sat_new_leaf_expression_node(ctx, entry -> result);
+    }
+
+    sat_expression_node * tr = sat_new_expression_node(ctx,
+                                                       SAT_EXPRESSION_NODE,
+                                                       NULL);
+    if(tr == NULL) {
+        return NULL;
+    }
+
+    tr -> op_type = op_type;
+
+    entry -> op     = op_type;
+    entry -> lhs    = lhs;
+    entry -> rhs    = rhs;
+    entry -> result = tr -> ir;
+    ctx -> structure_table_used += 1;
+
+    return tr;
+}
+
+
 /*!
 @brief Create a new sat_expression_node object for a unary operation
+@param [inout] ctx - The context to create the node in.
 @param [in] child - The child node the unary op is performed on.
 @param [in] op_type - What sort of operation is being performed?
 @returns A pointer to a newly created sat_expression_node or NULL if the
@@ -260,22 +561,22 @@ memory allocation fails.
 @warning Asserts that op_type is indeed a unary op!
 */
 sat_expression_node * sat_new_unary_expression_node (
+    sat_context         * ctx,
     sat_expression_node * child,
     sat_binary_op         op_type
 ) {
     assert(op_type == SAT_NOT);
     assert(child   != NULL);
 
-    sat_expression_node * tr = sat_new_expression_node(SAT_EXPRESSION_NODE,
-                                                       NULL);
+    sat_expression_node * tr = sat_new_hashed_expression_node(
+        ctx, op_type, child -> ir -> uid, child -> ir -> uid);
 
-    if(tr == NULL)
+    if(tr == NULL || tr -> node_type == SAT_EXPRESSION_LEAF)
     {
-        return NULL;
+        return tr;
     }
     else
     {
-        tr -> op_type                 = op_type;
         tr -> node.unary_operands.rhs = child;
         return tr;
     }
@@ -284,6 +585,7 @@ sat_expression_node * sat_new_unary_expression_node (
 
 /*!
 @brief Create a new sat_expression_node object for a binary operation
+@param [inout] ctx - The context to create the node in.
 @param [in] lhs - left hand node of the operation
 @param [in] rhs - right hand node of the operation
 @param [in] op_type - What sort of operation is being performed?
@@ -292,6 +594,7 @@ memory allocation fails.
 @warning Asserts that op_type is indeed a binary op!
 */
 sat_expression_node * sat_new_binary_expression_node (
+    sat_context         * ctx,
     sat_expression_node * lhs,
     sat_expression_node * rhs,
     sat_binary_op         op_type
@@ -303,18 +606,18 @@ sat_expression_node * sat_new_binary_expression_node (
            op_type == SAT_NOR ||
            op_type == SAT_NAND||
            op_type == SAT_NXOR||
-           op_type == SAT_XOR );
+           op_type == SAT_XOR ||
+           op_type == SAT_IMP );
 
-    sat_expression_node * tr = sat_new_expression_node(SAT_EXPRESSION_NODE,
-                                                       NULL);
+    sat_expression_node * tr = sat_new_hashed_expression_node(
+        ctx, op_type, lhs -> ir -> uid, rhs -> ir -> uid);
 
-    if(tr == NULL)
+    if(tr == NULL || tr -> node_type == SAT_EXPRESSION_LEAF)
     {
-        return NULL;
+        return tr;
     }
     else
     {
-        tr -> op_type  = op_type;
         tr -> node.binary_operands.lhs = lhs;
         tr -> node.binary_operands.rhs = rhs;
         return tr;
@@ -327,13 +630,15 @@ sat_expression_node * sat_new_binary_expression_node (
 @returns a pointer to the new assignment or NULL if the assignment fails.
 */
 sat_assignment * sat_new_assignment (
+    sat_context             * ctx,        //!< Context to allocate from.
     sat_expression_variable * variable,   //!< The variable being assigned to.
     sat_expression_node     * expression  //!< Expression whoes value to take.
 ){
     assert(variable != NULL);
     assert(expression != NULL);
 
-    sat_assignment * tr = calloc(1, sizeof(sat_assignment));
+    sat_assignment * tr = arena_alloc(sat_get_ast_arena(ctx),
+                                      sizeof(sat_assignment));
 
     if(tr == NULL)
     {
@@ -348,32 +653,6 @@ sat_assignment * sat_new_assignment (
 }
 
 
-/*!
-@brief Frees an assignmnet from memory along with all child expression
-data structures. It does *not* free the expression variables however.
-Can also free the pointed to <next> sat_assignment member.
-@param [in] tofree - pointer to the assignmen to be free'd.
-@param [in] freelist - Should we also recursively free the *next item in the
-linked list?
-*/
-void sat_free_assignment(
-    sat_assignment * tofree,
-    t_sat_bool       freelist
-){
-    assert(tofree               != NULL);
-    assert(tofree -> expression != NULL);
-
-    if(freelist && tofree -> next != NULL) {
-        sat_free_assignment(tofree -> next, SAT_TRUE);
-    }
-    
-    sat_free_expression_node(tofree -> expression);
-
-    free(tofree);
-}
-
-
-
 /*!
 @brief Adds an expression and all sub-expressions into the implication matrix.
 @param [in] depth - How deep is this nested expression? 0 indicates the root.
@@ -410,7 +689,7 @@ void sat_add_expression_to_imp_matrix(
                toadd -> op_type == SAT_NOR  ||
                toadd -> op_type == SAT_XOR  ||
                toadd -> op_type == SAT_NXOR ||
-               toadd -> op_type == SAT_AND  ){
+               toadd -> op_type == SAT_IMP  ){
 
         // Binary AND OP.
         sat_add_expression_to_imp_matrix(depth+1,matrix, 
@@ -450,6 +729,8 @@ void sat_apply_unary_constraints(
 /*!
 @brief Takes a single assignment expression and adds it to the implication
 matrix.
+@details A variable keeps its first assignment. Later assignments to it are
+ignored, with a warning on stderr.
 @param [in]out matrix - The matrix to add the assignment to
 @param [in]    toadd  - The assignment to add to the matrix.
 */
@@ -460,10 +741,23 @@ void sat_add_assignment_to_imp_matrix(
     assert(matrix != NULL);
     assert(toadd  != NULL);
 
+    sat_var_idx uid      = toadd -> variable -> uid;
+    t_sat_bool  assigned = uid < matrix -> variable_count &&
+                           matrix -> relations[uid].op != SAT_INPUT;
+
     sat_apply_unary_constraints(matrix,toadd -> variable);
 
+    // The expression is compiled even when the assignment is ignored, since
+    // its sub-expressions are already in the structure table and later
+    // assignments may share them.
     sat_add_expression_to_imp_matrix(0,matrix, toadd -> expression);
 
+    if(assigned) {
+        fprintf(stderr, "Warning: '%s' is already assigned, ignoring a later "
+                        "assignment to it.\n", toadd -> variable -> name);
+        return;
+    }
+
     if(toadd -> variable != toadd -> expression -> ir) {
         sat_add_relation(matrix,
                          toadd -> variable -> uid,
@@ -492,14 +786,16 @@ t_sat_bool sat_check_expectations(
     if( (var -> expect_0 != sat_value_in_domain(matrix,var->uid,SAT_FALSE)) ||
         (var -> expect_1 != sat_value_in_domain(matrix,var->uid,SAT_TRUE ))  )
     {
-        printf("Expected {%d %d} for %s (%d), got {%d %d}\n",
-            var -> expect_0,
-            var -> expect_1,
-            var -> name,
-            var -> uid,
-            sat_value_in_domain(matrix,var->uid,SAT_FALSE),
-            sat_value_in_domain(matrix,var->uid,SAT_TRUE )
-        );
+        if(print_failures) {
+            printf("Expected {%d %d} for %s (%d), got {%d %d}\n",
+                var -> expect_0,
+                var -> expect_1,
+                var -> name,
+                var -> uid,
+                sat_value_in_domain(matrix,var->uid,SAT_FALSE),
+                sat_value_in_domain(matrix,var->uid,SAT_TRUE )
+            );
+        }
         return SAT_FALSE;
     }
     return SAT_TRUE;
@@ -1,6 +1,8 @@
 
 #include "satsolver.h"
 #include "imp-matrix.h"
+#include "arena.h"
+#include "sats.h"
 
 #ifndef H_SATEXPRESSION
 #define H_SATEXPRESSION
@@ -23,11 +25,38 @@ typedef enum t_sat_expression_node_type {
 
 
 /*!
-@brief Returns the total number of leaf and intermediate variables in all
-parsed assignments.
-@returns unsigned integer.
+@brief Returns the arena which owns all expression variables and names.
+@details Variables live until the context is freed, so none of them are
+freed individually.
+@param [in] ctx - The context to look in.
+@returns A pointer to the front end arena.
 */
-unsigned int sat_get_variable_count();
+arena * sat_get_front_end_arena(
+    sat_context * ctx
+);
+
+
+/*!
+@brief Returns the arena which owns expression nodes and assignments.
+@details The parser empties this arena with sat_release_ast as soon as each
+assignment has been compiled, so it only ever holds one assignment's AST.
+@param [in] ctx - The context to look in.
+@returns A pointer to the AST arena.
+*/
+arena * sat_get_ast_arena(
+    sat_context * ctx
+);
+
+
+/*!
+@brief Discard every expression node and assignment created so far.
+@details Expression variables are not affected. Any pointers to nodes or
+assignments are invalid afterwards.
+@param [inout] ctx - The context to release the AST of.
+*/
+void sat_release_ast(
+    sat_context * ctx
+);
 
 
 /*!
@@ -59,51 +88,163 @@ struct t_sat_expression_variable {
 } ;
 
 /*!
-@brief A linked list of all unique expression variables.
-@details This is maintained when the sat_new_*_expression_variable function
-is called. If the variable being added already exists, it is returned from
-this list. Otherwise it is inserted into the list.
+@brief An operation on two variables whose result is already held by
+another variable.
+@details Used to find repeated sub-expressions. The operands of commutative
+operations are stored smallest uid first.
+*/
+typedef struct t_sat_structural_entry {
+    sat_binary_op             op;     //!< The operation.
+    sat_var_idx               lhs;    //!< Uid of the left hand operand.
+    sat_var_idx               rhs;    //!< Uid of the right hand operand.
+    sat_expression_variable * result; //!< Holds the result, NULL if unused.
+} sat_structural_entry;
+
+/*!
+@brief Everything the front end needs to parse one problem.
+@details Nothing is shared between contexts, so independent contexts can
+be used on different threads at the same time.
 */
-sat_expression_variable * yy_sat_variables;
+struct t_sat_context {
+    unsigned int     id_counter;    //!< Incremented for every new variable.
+    arena          * arena;         //!< Owns every variable and name.
+    arena          * ast_arena;     //!< Owns the assignment being parsed.
+    sat_imp_matrix * imp_matrix;    //!< Assignments are compiled into this.
+
+    //! Open addressing hash table of named variables, keyed on their name.
+    sat_expression_variable ** name_table;
+    unsigned int     name_table_size; //!< Zero or a power of two.
+    unsigned int     name_table_used; //!< Number of occupied slots.
+
+    //! Dense array of named variables, indexed by their uid.
+    sat_expression_variable ** uid_table;
+    unsigned int     uid_table_size;  //!< Number of entries allocated.
+
+    //! Open addressing hash table of operations, keyed on their operands.
+    sat_structural_entry     * structure_table;
+    unsigned int     structure_table_size; //!< Zero or a power of two.
+    unsigned int     structure_table_used; //!< Number of occupied slots.
+    unsigned int     merged_nodes;    //!< Operations found in the table.
+
+    /*!
+    @brief A linked list of all unique expression variables.
+    @details This is maintained when the sat_new_*_expression_variable
+    function is called. If the variable being added already exists, it is
+    found through name_table and returned. Otherwise it is appended to the
+    list, which is therefore ordered by uid.
+    */
+    sat_expression_variable  * variables;
+    sat_expression_variable  * variables_tail; //!< Last element of variables.
+
+    //! The variables standing for the constants 0 and 1, or NULL.
+    sat_expression_variable  * constants[2];
+
+    /*!
+    @brief A compiled problem the context was loaded from, or NULL.
+    @details When set, there are no expression variables. Names and
+    expectations are read straight from the mapped file instead, and the
+    matrix borrows its arrays from it.
+    */
+    void                     * mapping;
+    size_t                     mapping_size;  //!< Size of mapping in bytes.
+    const unsigned int       * mapped_name_offsets; //!< Into mapped_names.
+    const char               * mapped_names;  //!< Null terminated names.
+    const unsigned char      * mapped_expectations; //!< One per variable.
+};
 
 
 /*!
 @brief Create a new un-named SAT expression variable.
+@param [inout] ctx - The context to create the variable in.
 @returns A pointer to a newly created sat_expression_variable.
 */
-sat_expression_variable * sat_new_expression_variable();
+sat_expression_variable * sat_new_expression_variable(
+    sat_context * ctx
+);
+
+
+/*!
+@brief Returns a copy of a variable name which lives in the front end arena.
+@details If a variable with this name already exists, its name is returned
+rather than making a new copy. Used by the lexer so that repeated
+identifiers cost no memory.
+@param [inout] ctx - The context to intern the name in.
+@param [in] text - The name, which must be null terminated.
+@param [in] len  - Length of the name.
+@returns A pointer to the name in the front end arena.
+*/
+sat_var_name sat_intern_name(
+    sat_context * ctx,
+    const char  * text,
+    size_t        len
+);
 
 
 /*!
 @brief Create a new named SAT expression variable.
-@param [in] name  - Friendly name
+@details If a variable with this name already exists, it is returned instead.
+@param [inout] ctx - The context to create the variable in.
+@param [in] name  - Friendly name, which must be allocated from the front
+end arena.
 @returns A pointer to a newly created sat_expression_variable.
 */
 sat_expression_variable * sat_new_named_expression_variable(
+    sat_context   * ctx,
     sat_var_name    name
 );
 
 
+/*!
+@brief Returns the variable which stands for a constant in expressions.
+@details There is one variable per value in each context, created on first
+use. Its name starts with an underscore so it can never clash with a name
+from the input, and its domain only holds the value.
+@param [inout] ctx - The context to look in.
+@param [in] value - The constant.
+@returns A pointer to the expression variable.
+*/
+sat_expression_variable * sat_get_constant_variable(
+    sat_context * ctx,
+    t_sat_bool    value
+);
+
+
+/*!
+@brief Find an existing variable by name, without creating it.
+@param [in] ctx - The context to look in.
+@param [in] name - The name to search for.
+@returns A pointer to the expression variable or NULL if no such variable
+exists.
+*/
+sat_expression_variable * sat_find_named_expression_variable(
+    sat_context * ctx,
+    const char  * name
+);
+
+
 /*!
 @brief Returns the variable associated with the supplied ID.
+@param [in] ctx - The context to look in.
 @param [in] id - The unique id of the variable.
 @returns A pointer to the expression variable or NULL if no such variable
 exists.
 */
 sat_expression_variable * sat_get_variable_from_id(
+    sat_context   * ctx,
     sat_var_idx     id
 );
 
 
 /*!
-@brief Free the memory taken up by an expression variable.
-@param [in] tofree    - Pointer to the variable to free.
-@param [in] freelist  - Should we recursively free the *next field?
-@note Also frees the memory allocated for the name field of tofree.
+@brief Returns the table of all named variables, indexed by uid.
+@details The table has sat_get_variable_count() valid entries and is kept up
+to date as variables are created. It may move when new variables are added,
+so the pointer should not be held across calls which create variables.
+@param [in] ctx - The context to look in.
+@returns A pointer to the first element of the table.
 */
-void sat_free_expression_variable (
-    sat_expression_variable    * tofree,
-    t_sat_bool                   freelist
+sat_expression_variable ** sat_get_variable_table(
+    sat_context * ctx
 );
 
 
@@ -142,36 +283,29 @@ struct t_sat_expression_node {
     } node ;
 };
 
-/*!
-@brief Free the memory taken up by an expression node.
-@details Recursively fees this expression node and all sub-expression nodes,
-but leaves the leaf variables allocated for later use.
-@param [in] tofree    - Pointer to the expression node to free.
-*/
-void sat_free_expression_node(
-    sat_expression_node        * tofree
-);
-
-
 /*!
 @brief Create a new sat_expression_node object for a leaf variable.
+@param [inout] ctx - The context to create the node in.
 @param [in] variable - The leaf variable for the node.
 @returns A pointer to a newly created sat_expression_node or NULL if the
 memory allocation fails.
 */
 sat_expression_node * sat_new_leaf_expression_node (
+    sat_context             * ctx,
     sat_expression_variable * variable
 );
 
 
 /*!
 @brief Create a new sat_expression_node object for a unary operation
+@param [inout] ctx - The context to create the node in.
 @param [in] child - The child node the unary op is performed on.
 @param [in] op_type - What sort of operation is being performed?
 @returns A pointer to a newly created sat_expression_node or NULL if the
 memory allocation fails.
 */
 sat_expression_node * sat_new_unary_expression_node (
+    sat_context         * ctx,
     sat_expression_node * child,
     sat_binary_op         op_type
 );
@@ -179,6 +313,7 @@ sat_expression_node * sat_new_unary_expression_node (
 
 /*!
 @brief Create a new sat_expression_node object for a binary operation
+@param [inout] ctx - The context to create the node in.
 @param [in] lhs - left hand node of the operation
 @param [in] rhs - right hand node of the operation
 @param [in] op_type - What sort of operation is being performed?
@@ -186,6 +321,7 @@ sat_expression_node * sat_new_unary_expression_node (
 memory allocation fails.
 */
 sat_expression_node * sat_new_binary_expression_node (
+    sat_context         * ctx,
     sat_expression_node * lhs,
     sat_expression_node * rhs,
     sat_binary_op         op_type
@@ -194,15 +330,9 @@ sat_expression_node * sat_new_binary_expression_node (
 //! Typedef for representing a single assignment to a single variable.
 typedef struct t_sat_assignment sat_assignment;
 
-/*!
-@brief Global variable containing a linked list of assignment expressions.
-*/
-sat_assignment * yy_assignments;
-
 struct t_sat_assignment {
     sat_expression_variable * variable;   //!< The variable being assigned to.
     sat_expression_node     * expression; //!< Expression whoes value to take.
-    sat_assignment          * next; //!< Next in linked list.
 };
 
 
@@ -211,23 +341,11 @@ struct t_sat_assignment {
 @returns a pointer to the new assignment or NULL if the assignment fails.
 */
 sat_assignment * sat_new_assignment (
+    sat_context             * ctx,        //!< Context to allocate from.
     sat_expression_variable * variable,   //!< The variable being assigned to.
     sat_expression_node     * expression  //!< Expression whoes value to take.
 );
 
-/*!
-@brief Frees an assignmnet from memory along with all child expression
-data structures. It does *not* free the expression variables however.
-Can also free the pointed to <next> sat_assignment member.
-@param [in] tofree - pointer to the assignmen to be free'd.
-@param [in] freelist - Should we also recursively free the *next item in the
-linked list?
-*/
-void sat_free_assignment(
-    sat_assignment * tofree,
-    t_sat_bool       freelist
-);
-
 /*!
 @brief Apply any unary constraints on the value of a variable to an
 implication matrix.
@@ -240,6 +358,8 @@ void sat_apply_unary_constraints(
 /*!
 @brief Takes a single assignment expression and adds it to the implication
 matrix.
+@details A variable keeps its first assignment. Later assignments to it are
+ignored, with a warning on stderr.
 @param [inout] matrix - The matrix to add the assignment to
 @param [in]    toadd  - The assignment to add to the matrix.
 */
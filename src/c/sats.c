@@ -0,0 +1,344 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <sys/mman.h>
+
+#include "sats.h"
+#include "compiled.h"
+#include "sat-expression.h"
+#include "sat-expression-parser.h"
+
+// The scanner is generated with the bison bridge, and expects YYSTYPE to
+// name the semantic value type of the (prefixed) parser.
+#define YYSTYPE SATYYSTYPE
+#include "sat-expression-scanner.h"
+
+/*!
+@brief Create a new, empty context.
+@returns A pointer to the new context, to be freed with sat_free_context.
+*/
+sat_context * sat_new_context()
+{
+    sat_context * tr = calloc(1, sizeof(sat_context));
+    tr -> imp_matrix = sat_new_imp_matrix(0);
+    return tr;
+}
+
+
+/*!
+@brief Free a context, its matrix, and every variable parsed into it.
+@param [in] tofree - The context to free.
+*/
+void sat_free_context(
+    sat_context * tofree
+){
+    if(tofree -> arena != NULL) {
+        arena_free(tofree -> arena);
+    }
+    if(tofree -> ast_arena != NULL) {
+        arena_free(tofree -> ast_arena);
+    }
+
+    free(tofree -> uid_table);
+    free(tofree -> name_table);
+    free(tofree -> structure_table);
+
+    // The matrix may borrow from the mapping, so it must go first.
+    sat_free_imp_matrix(tofree -> imp_matrix);
+
+    if(tofree -> mapping != NULL) {
+        munmap(tofree -> mapping, tofree -> mapping_size);
+    }
+    free(tofree);
+}
+
+
+/*!
+@brief Make sure the matrix covers every variable parsed so far.
+@details Some variables may only appear in expectations, and so never get a
+relation of their own while parsing.
+@param [inout] ctx - The context to update.
+*/
+static void sat_finish_parse(
+    sat_context * ctx
+){
+    sat_resize_imp_matrix(ctx -> imp_matrix, ctx -> id_counter);
+}
+
+
+/*!
+@brief Parse a problem from a file into a context.
+@details Assignments and unary constraints are compiled into the context's
+matrix as they are read.
+@param [inout] ctx - The context to parse into.
+@param [in] input - The file to read, which is not closed.
+@returns 0 on success, non-zero on a syntax error.
+*/
+int sat_parse_file(
+    sat_context * ctx,
+    FILE        * input
+){
+    assert(ctx != NULL);
+    assert(ctx -> mapping == NULL);
+    assert(input != NULL);
+
+    yyscan_t scanner;
+    satyylex_init_extra(ctx, &scanner);
+    satyyset_in(input, scanner);
+
+    int tr = satyyparse(ctx, scanner);
+
+    satyylex_destroy(scanner);
+    sat_release_ast(ctx);
+    sat_finish_parse(ctx);
+
+    return tr;
+}
+
+
+/*!
+@brief Parse a problem held in a string into a context.
+@param [inout] ctx - The context to parse into.
+@param [in] text - The problem, in the same format as an input file.
+@returns 0 on success, non-zero on a syntax error.
+*/
+int sat_parse_string(
+    sat_context * ctx,
+    const char  * text
+){
+    assert(ctx != NULL);
+    assert(ctx -> mapping == NULL);
+    assert(text != NULL);
+
+    yyscan_t scanner;
+    satyylex_init_extra(ctx, &scanner);
+
+    YY_BUFFER_STATE buffer = satyy_scan_string(text, scanner);
+
+    int tr = satyyparse(ctx, scanner);
+
+    satyy_delete_buffer(buffer, scanner);
+    satyylex_destroy(scanner);
+    sat_release_ast(ctx);
+    sat_finish_parse(ctx);
+
+    return tr;
+}
+
+
+/*!
+@brief Load a problem from a file, which may be text or compiled.
+@param [inout] ctx - A context which nothing has been parsed into yet.
+@param [in] path - The file to load.
+@returns SAT_LOAD_OK, SAT_LOAD_UNREADABLE or SAT_LOAD_INVALID.
+*/
+int sat_load_file(
+    sat_context * ctx,
+    const char  * path
+){
+    FILE * input = fopen(path, "r");
+
+    if(input == NULL) {
+        return SAT_LOAD_UNREADABLE;
+    }
+
+    char magic[sizeof(SAT_COMPILED_MAGIC) - 1];
+    if(fread(magic, 1, sizeof(magic), input) == sizeof(magic) &&
+       memcmp(magic, SAT_COMPILED_MAGIC, sizeof(magic)) == 0) {
+        fclose(input);
+        return sat_load_compiled(ctx, path);
+    }
+
+    rewind(input);
+    int result = sat_parse_file(ctx, input);
+    fclose(input);
+
+    return result ? SAT_LOAD_INVALID : SAT_LOAD_OK;
+}
+
+
+/*!
+@brief Returns the matrix a context's problem has been compiled into.
+@param [in] ctx - The context to look in.
+@returns A pointer to the matrix.
+*/
+sat_imp_matrix * sat_get_imp_matrix(
+    sat_context * ctx
+){
+    return ctx -> imp_matrix;
+}
+
+
+/*!
+@brief Returns the total number of leaf and intermediate variables in all
+parsed assignments.
+@param [in] ctx - The context to look in.
+@returns unsigned integer.
+*/
+unsigned int sat_get_variable_count(
+    sat_context * ctx
+){
+    return ctx -> id_counter;
+}
+
+
+/*!
+@brief Returns how many repeated sub-expressions were found while parsing.
+@details Each one shares the variable and relation of the first occurrence
+rather than adding its own.
+@param [in] ctx - The context to look in.
+@returns unsigned integer.
+*/
+unsigned int sat_get_merged_node_count(
+    sat_context * ctx
+){
+    return ctx -> merged_nodes;
+}
+
+
+/*!
+@brief Returns the name of a variable.
+@param [in] ctx - The context to look in.
+@param [in] variable - Index of the variable in the matrix.
+@returns The name, or NULL if there is no such variable.
+*/
+const char * sat_get_variable_name(
+    sat_context * ctx,
+    sat_var_idx   variable
+){
+    if(ctx -> mapping != NULL) {
+        if(variable >= ctx -> id_counter) {
+            return NULL;
+        }
+        return ctx -> mapped_names + ctx -> mapped_name_offsets[variable];
+    }
+
+    sat_expression_variable * var = sat_get_variable_from_id(ctx, variable);
+    return var == NULL ? NULL : var -> name;
+}
+
+
+/*!
+@brief Look a variable up by name.
+@param [in] ctx - The context to look in.
+@param [in] name - The name of the variable.
+@param [out] variable - Set to the index of the variable in the matrix.
+@returns SAT_TRUE if the variable exists.
+*/
+t_sat_bool sat_find_variable(
+    sat_context * ctx,
+    const char  * name,
+    sat_var_idx * variable
+){
+    if(ctx -> mapping != NULL) {
+        // Compiled files have no hash table, since loading one should cost
+        // nothing, so fall back to a scan.
+        sat_var_idx vi;
+        for(vi = 0; vi < ctx -> id_counter; vi ++) {
+            if(strcmp(sat_get_variable_name(ctx, vi), name) == 0) {
+                *variable = vi;
+                return SAT_TRUE;
+            }
+        }
+        return SAT_FALSE;
+    }
+
+    sat_expression_variable * var = sat_find_named_expression_variable(ctx,
+                                                                        name);
+    if(var == NULL) {
+        return SAT_FALSE;
+    }
+    *variable = var -> uid;
+    return SAT_TRUE;
+}
+
+
+/*!
+@brief Check whether a variable has an `expect domain` line.
+@param [in] ctx - The context to look in.
+@param [in] variable - Index of the variable in the matrix.
+@returns SAT_TRUE if the variable's domain is checked by
+sat_variable_expectations_met.
+*/
+t_sat_bool sat_variable_has_expectation(
+    sat_context * ctx,
+    sat_var_idx   variable
+){
+    if(ctx -> mapping != NULL) {
+        return variable < ctx -> id_counter &&
+               (ctx -> mapped_expectations[variable] & SAT_COMPILED_CHECK);
+    }
+
+    sat_expression_variable * var = sat_get_variable_from_id(ctx, variable);
+    return var != NULL && var -> check_domain;
+}
+
+
+/*!
+@brief Check the `expect domain` line, if any, for one variable against its
+current domain.
+@param [in] ctx - The context to check.
+@param [in] variable - Index of the variable in the matrix.
+@param [in] print_failures - If true, print the expectation if it is unmet.
+@returns SAT_TRUE if the variable has no expectation, or it was met.
+*/
+t_sat_bool sat_variable_expectations_met(
+    sat_context * ctx,
+    sat_var_idx   variable,
+    t_sat_bool    print_failures
+){
+    if(ctx -> mapping == NULL) {
+        sat_expression_variable * var = sat_get_variable_from_id(ctx,
+                                                                 variable);
+        return var == NULL ||
+               sat_check_expectations(var, ctx -> imp_matrix,
+                                      print_failures);
+    }
+
+    unsigned char flags = ctx -> mapped_expectations[variable];
+
+    if(!(flags & SAT_COMPILED_CHECK)) {
+        return SAT_TRUE;
+    }
+
+    t_sat_bool expect_0 = (flags & SAT_COMPILED_EXPECT_0) != 0;
+    t_sat_bool expect_1 = (flags & SAT_COMPILED_EXPECT_1) != 0;
+    t_sat_bool got_0    = sat_value_in_domain(ctx -> imp_matrix, variable,
+                                              SAT_FALSE);
+    t_sat_bool got_1    = sat_value_in_domain(ctx -> imp_matrix, variable,
+                                              SAT_TRUE);
+
+    if(expect_0 != got_0 || expect_1 != got_1) {
+        if(print_failures) {
+            printf("Expected {%d %d} for %s (%d), got {%d %d}\n",
+                expect_0, expect_1, sat_get_variable_name(ctx, variable),
+                variable, got_0, got_1);
+        }
+        return SAT_FALSE;
+    }
+    return SAT_TRUE;
+}
+
+
+/*!
+@brief Check every `expect domain` line parsed into a context against the
+current domains of its matrix.
+@param [in] ctx - The context to check.
+@param [in] print_failures - If true, print each unmet expectation.
+@returns SAT_TRUE if every expectation was met.
+*/
+t_sat_bool sat_expectations_met(
+    sat_context * ctx,
+    t_sat_bool    print_failures
+){
+    t_sat_bool  tr = SAT_TRUE;
+    sat_var_idx vi;
+
+    for(vi = 0; vi < ctx -> id_counter; vi ++) {
+        tr &= sat_variable_expectations_met(ctx, vi, print_failures);
+    }
+    return tr;
+}
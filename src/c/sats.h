@@ -0,0 +1,205 @@
+
+#include <stdio.h>
+
+#include "satsolver.h"
+#include "imp-matrix.h"
+#include "levels.h"
+#include "async.h"
+#include "search.h"
+#include "incremental.h"
+
+#ifndef H_SATS
+#define H_SATS
+
+/*!
+@defgroup gr-sats Library Interface
+
+@brief The public interface of libsats.
+
+@details A sat_context holds everything needed to parse one problem and the
+implication matrix it is compiled into. There is no global state, so a
+program may hold any number of contexts, and use independent contexts on
+different threads at the same time. A single context must only be used by
+one thread at a time.
+
+Once parsed, the matrix returned by sat_get_imp_matrix can be handed to any
+of the solvers: sat_solve, sat_solve_levelized, sat_solve_parallel,
+sat_solve_async, sat_search or the incremental solver.
+
+@addtogroup gr-sats
+@{
+*/
+
+//! Opaque handle to one problem and everything parsed into it.
+typedef struct t_sat_context sat_context;
+
+//! Returned by sat_load_file when the problem was loaded.
+#define SAT_LOAD_OK         0
+//! Returned by sat_load_file when the file could not be opened.
+#define SAT_LOAD_UNREADABLE 1
+//! Returned by sat_load_file when the file has a syntax error, or is a
+//! compiled file which cannot be read.
+#define SAT_LOAD_INVALID    2
+
+
+/*!
+@brief Create a new, empty context.
+@returns A pointer to the new context, to be freed with sat_free_context.
+*/
+sat_context * sat_new_context();
+
+
+/*!
+@brief Free a context, its matrix, and every variable parsed into it.
+@param [in] tofree - The context to free.
+*/
+void sat_free_context(
+    sat_context * tofree
+);
+
+
+/*!
+@brief Parse a problem from a file into a context.
+@details Assignments and unary constraints are compiled into the context's
+matrix as they are read. Parsing more than one input into the same context
+adds to the problem already there.
+@param [inout] ctx - The context to parse into.
+@param [in] input - The file to read, which is not closed.
+@returns 0 on success, non-zero on a syntax error.
+*/
+int sat_parse_file(
+    sat_context * ctx,
+    FILE        * input
+);
+
+
+/*!
+@brief Parse a problem held in a string into a context.
+@param [inout] ctx - The context to parse into.
+@param [in] text - The problem, in the same format as an input file.
+@returns 0 on success, non-zero on a syntax error.
+*/
+int sat_parse_string(
+    sat_context * ctx,
+    const char  * text
+);
+
+
+/*!
+@brief Load a problem from a file, which may be text or compiled.
+@details Compiled files, written by sat_write_compiled, are recognised by
+their first bytes and mapped rather than parsed.
+@param [inout] ctx - A context which nothing has been parsed into yet.
+@param [in] path - The file to load.
+@returns SAT_LOAD_OK, SAT_LOAD_UNREADABLE or SAT_LOAD_INVALID.
+*/
+int sat_load_file(
+    sat_context * ctx,
+    const char  * path
+);
+
+
+/*!
+@brief Returns the matrix a context's problem has been compiled into.
+@details The matrix is owned by the context.
+@param [in] ctx - The context to look in.
+@returns A pointer to the matrix.
+*/
+sat_imp_matrix * sat_get_imp_matrix(
+    sat_context * ctx
+);
+
+
+/*!
+@brief Returns the total number of leaf and intermediate variables in all
+parsed assignments.
+@param [in] ctx - The context to look in.
+@returns unsigned integer.
+*/
+unsigned int sat_get_variable_count(
+    sat_context * ctx
+);
+
+
+/*!
+@brief Returns how many repeated sub-expressions were found while parsing.
+@details Each one shares the variable and relation of the first occurrence
+rather than adding its own.
+@param [in] ctx - The context to look in.
+@returns unsigned integer.
+*/
+unsigned int sat_get_merged_node_count(
+    sat_context * ctx
+);
+
+
+/*!
+@brief Returns the name of a variable.
+@param [in] ctx - The context to look in.
+@param [in] variable - Index of the variable in the matrix.
+@returns The name, which lives as long as the context, or NULL if there is
+no such variable.
+*/
+const char * sat_get_variable_name(
+    sat_context * ctx,
+    sat_var_idx   variable
+);
+
+
+/*!
+@brief Look a variable up by name.
+@param [in] ctx - The context to look in.
+@param [in] name - The name of the variable.
+@param [out] variable - Set to the index of the variable in the matrix.
+@returns SAT_TRUE if the variable exists.
+*/
+t_sat_bool sat_find_variable(
+    sat_context * ctx,
+    const char  * name,
+    sat_var_idx * variable
+);
+
+
+/*!
+@brief Check whether a variable has an `expect domain` line.
+@param [in] ctx - The context to look in.
+@param [in] variable - Index of the variable in the matrix.
+@returns SAT_TRUE if the variable's domain is checked by
+sat_variable_expectations_met.
+*/
+t_sat_bool sat_variable_has_expectation(
+    sat_context * ctx,
+    sat_var_idx   variable
+);
+
+
+/*!
+@brief Check the `expect domain` line, if any, for one variable against its
+current domain.
+@param [in] ctx - The context to check.
+@param [in] variable - Index of the variable in the matrix.
+@param [in] print_failures - If true, print the expectation if it is unmet.
+@returns SAT_TRUE if the variable has no expectation, or it was met.
+*/
+t_sat_bool sat_variable_expectations_met(
+    sat_context * ctx,
+    sat_var_idx   variable,
+    t_sat_bool    print_failures
+);
+
+
+/*!
+@brief Check every `expect domain` line parsed into a context against the
+current domains of its matrix.
+@param [in] ctx - The context to check.
+@param [in] print_failures - If true, print each unmet expectation.
+@returns SAT_TRUE if every expectation was met.
+*/
+t_sat_bool sat_expectations_met(
+    sat_context * ctx,
+    t_sat_bool    print_failures
+);
+
+/*! @} */
+
+#endif
@@ -0,0 +1,871 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "search.h"
+
+//! A literal is a variable together with a value, 2 * variable + value.
+typedef unsigned int sat_lit;
+
+//! The literal saying that variable takes value.
+#define SAT_LIT(variable, value) (2 * (variable) + (value))
+
+//! The variable a literal is about.
+#define SAT_LIT_VAR(lit) ((lit) >> 1)
+
+//! The literal saying that the variable takes the other value.
+#define SAT_LIT_NEG(lit) ((lit) ^ 1)
+
+//! Marks a variable which was decided or set before the search began.
+#define SAT_REASON_NONE     0
+//! Marks a variable whose value was implied by a relation.
+#define SAT_REASON_RELATION 1
+//! Marks a variable whose value was implied by a learnt clause.
+#define SAT_REASON_CLAUSE   2
+
+//! Conflicts between restarts are this times the Luby sequence.
+#define SAT_RESTART_UNIT    100
+
+//! Activities are multiplied by this after each conflict.
+#define SAT_ACTIVITY_DECAY  0.95
+
+/*!
+@brief A growable array of clause indexes watching one literal.
+*/
+typedef struct sat_watch_list_t {
+    unsigned int * items;       //!< Indexes of the watching clauses.
+    unsigned int   count;       //!< Number of items in use.
+    unsigned int   capacity;    //!< Number of items allocated.
+} sat_watch_list;
+
+/*!
+@brief Everything the search needs besides the matrix itself.
+*/
+typedef struct sat_search_state_t {
+    sat_imp_matrix * imp_mat;       //!< The matrix being searched.
+    unsigned int     n;             //!< Number of variables.
+
+    sat_var_idx    * trail;         //!< Variables in the order they were set.
+    unsigned int     trail_length;  //!< Number of variables on the trail.
+    unsigned int     queue_head;    //!< Next trail entry to propagate.
+    unsigned int   * level_start;   //!< Trail length at each decision.
+    unsigned int     level;         //!< Current decision level.
+
+    unsigned int   * var_level;     //!< Decision level each variable was set.
+    unsigned int   * trail_pos;     //!< Where each variable is on the trail.
+    unsigned int   * reason;        //!< Relation or clause implying a value.
+    unsigned char  * reason_kind;   //!< One of the SAT_REASON_* values.
+    unsigned char  * seen;          //!< Scratch flags for conflict analysis.
+    unsigned char  * phase;         //!< Value each variable last had.
+
+    double         * activity;      //!< VSIDS activity of each variable.
+    double           activity_inc;  //!< Amount added by the next bump.
+    sat_var_idx    * heap;          //!< Decision order, best first.
+    int            * heap_pos;      //!< Index of each variable in heap, or -1.
+    unsigned int     heap_size;     //!< Number of variables in the heap.
+
+    sat_lit        * lits;          //!< Literals of every learnt clause.
+    unsigned int     lits_length;   //!< Number of literals in use.
+    unsigned int     lits_capacity; //!< Number of literals allocated.
+    unsigned int   * clause_start;  //!< Offset of each clause in lits.
+    unsigned int   * clause_size;   //!< Number of literals in each clause.
+    unsigned int     clause_count;  //!< Number of learnt clauses.
+    unsigned int     clause_capacity; //!< Number of clauses allocated.
+    sat_watch_list * watches;       //!< Clauses watching each literal.
+
+    sat_lit        * learnt;        //!< Scratch clause for conflict analysis.
+    sat_search_stats stats;         //!< Counters for the caller.
+} sat_search_state;
+
+
+// ---------------------------------------------------------------------------
+// Decision heap.
+
+/*!
+@brief Whether variable a should be decided before variable b.
+@details Inputs always come first, since once they are set the relations
+can usually work out everything else.
+*/
+static t_sat_bool sat_heap_before(
+    sat_search_state * s,
+    sat_var_idx        a,
+    sat_var_idx        b
+){
+    t_sat_bool a_in = sat_is_input(s -> imp_mat, a);
+    t_sat_bool b_in = sat_is_input(s -> imp_mat, b);
+
+    if(a_in != b_in) {
+        return a_in;
+    }
+    return s -> activity[a] > s -> activity[b];
+}
+
+
+//! Move the variable at heap index i up towards the root.
+static void sat_heap_up(
+    sat_search_state * s,
+    unsigned int       i
+){
+    sat_var_idx v = s -> heap[i];
+
+    while(i > 0) {
+        unsigned int parent = (i - 1) / 2;
+        if(!sat_heap_before(s, v, s -> heap[parent])) break;
+        s -> heap[i] = s -> heap[parent];
+        s -> heap_pos[s -> heap[i]] = i;
+        i = parent;
+    }
+
+    s -> heap[i]    = v;
+    s -> heap_pos[v] = i;
+}
+
+
+//! Move the variable at heap index i down towards the leaves.
+static void sat_heap_down(
+    sat_search_state * s,
+    unsigned int       i
+){
+    sat_var_idx v = s -> heap[i];
+
+    while(2 * i + 1 < s -> heap_size) {
+        unsigned int child = 2 * i + 1;
+        if(child + 1 < s -> heap_size &&
+           sat_heap_before(s, s -> heap[child + 1], s -> heap[child])) {
+            child += 1;
+        }
+        if(!sat_heap_before(s, s -> heap[child], v)) break;
+        s -> heap[i] = s -> heap[child];
+        s -> heap_pos[s -> heap[i]] = i;
+        i = child;
+    }
+
+    s -> heap[i]    = v;
+    s -> heap_pos[v] = i;
+}
+
+
+//! Add a variable to the heap if it is not already there.
+static void sat_heap_insert(
+    sat_search_state * s,
+    sat_var_idx        v
+){
+    if(s -> heap_pos[v] >= 0) return;
+
+    s -> heap[s -> heap_size] = v;
+    s -> heap_size += 1;
+    sat_heap_up(s, s -> heap_size - 1);
+}
+
+
+//! Remove and return the best variable in the heap.
+static sat_var_idx sat_heap_pop(
+    sat_search_state * s
+){
+    sat_var_idx tr = s -> heap[0];
+
+    s -> heap_size -= 1;
+    s -> heap_pos[tr] = -1;
+
+    if(s -> heap_size > 0) {
+        s -> heap[0] = s -> heap[s -> heap_size];
+        sat_heap_down(s, 0);
+    }
+
+    return tr;
+}
+
+
+//! Increase the activity of a variable which took part in a conflict.
+static void sat_bump_activity(
+    sat_search_state * s,
+    sat_var_idx        v
+){
+    s -> activity[v] += s -> activity_inc;
+
+    if(s -> activity[v] > 1e100) {
+        unsigned int i;
+        for(i = 0; i < s -> n; i += 1) {
+            s -> activity[i] *= 1e-100;
+        }
+        s -> activity_inc *= 1e-100;
+    }
+
+    if(s -> heap_pos[v] >= 0) {
+        sat_heap_up(s, s -> heap_pos[v]);
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Trail.
+
+/*!
+@brief Whether a variable currently holds a single value.
+*/
+static t_sat_bool sat_search_assigned(
+    sat_search_state * s,
+    sat_var_idx        v
+){
+    t_sat_bool bits = sat_get_domain_bits(s -> imp_mat, v);
+    return bits == SAT_DOMAIN_0 || bits == SAT_DOMAIN_1;
+}
+
+
+/*!
+@brief The value of a variable which is assigned.
+*/
+static t_sat_bool sat_search_value(
+    sat_search_state * s,
+    sat_var_idx        v
+){
+    return sat_get_domain_bits(s -> imp_mat, v) == SAT_DOMAIN_1;
+}
+
+
+/*!
+@brief Whether a literal is true (1), false (0) or unknown (-1).
+*/
+static int sat_lit_value(
+    sat_search_state * s,
+    sat_lit            lit
+){
+    t_sat_bool bits = sat_get_domain_bits(s -> imp_mat, SAT_LIT_VAR(lit));
+
+    if(bits == SAT_DOMAIN_ALL) {
+        return -1;
+    }
+    return bits == (1 << (lit & 1));
+}
+
+
+/*!
+@brief Give a variable a single value and record it on the trail.
+*/
+static void sat_search_assign(
+    sat_search_state * s,
+    sat_lit            lit,
+    unsigned char      kind,
+    unsigned int       reason
+){
+    sat_var_idx v = SAT_LIT_VAR(lit);
+
+    sat_set_domain_bits(s -> imp_mat, v, 1 << (lit & 1));
+
+    s -> var_level  [v] = s -> level;
+    s -> trail_pos  [v] = s -> trail_length;
+    s -> reason     [v] = reason;
+    s -> reason_kind[v] = kind;
+    s -> trail[s -> trail_length ++] = v;
+}
+
+
+/*!
+@brief Undo every value set after the given decision level.
+*/
+static void sat_search_backtrack(
+    sat_search_state * s,
+    unsigned int       level
+){
+    if(s -> level <= level) return;
+
+    unsigned int keep = s -> level_start[level + 1];
+
+    while(s -> trail_length > keep) {
+        sat_var_idx v = s -> trail[-- s -> trail_length];
+        s -> phase[v] = sat_search_value(s, v);
+        sat_set_domain_bits(s -> imp_mat, v, SAT_DOMAIN_ALL);
+        sat_heap_insert(s, v);
+    }
+
+    s -> queue_head = keep;
+    s -> level      = level;
+}
+
+
+// ---------------------------------------------------------------------------
+// Learnt clauses.
+
+//! Add a clause index to the watch list of a literal.
+static void sat_watch(
+    sat_search_state * s,
+    sat_lit            lit,
+    unsigned int       clause
+){
+    sat_watch_list * w = &s -> watches[lit];
+
+    if(w -> count == w -> capacity) {
+        w -> capacity = w -> capacity ? w -> capacity * 2 : 4;
+        w -> items    = realloc(w -> items,
+                                w -> capacity * sizeof(unsigned int));
+    }
+
+    w -> items[w -> count ++] = clause;
+}
+
+
+/*!
+@brief Store a learnt clause and watch its first two literals.
+@returns The index of the new clause.
+*/
+static unsigned int sat_add_clause(
+    sat_search_state * s,
+    sat_lit          * lits,
+    unsigned int       size
+){
+    if(s -> lits_length + size > s -> lits_capacity) {
+        while(s -> lits_length + size > s -> lits_capacity) {
+            s -> lits_capacity = s -> lits_capacity ?
+                                 s -> lits_capacity * 2 : 1024;
+        }
+        s -> lits = realloc(s -> lits, s -> lits_capacity * sizeof(sat_lit));
+    }
+
+    if(s -> clause_count == s -> clause_capacity) {
+        s -> clause_capacity = s -> clause_capacity ?
+                               s -> clause_capacity * 2 : 256;
+        s -> clause_start = realloc(s -> clause_start,
+                                    s -> clause_capacity *
+                                    sizeof(unsigned int));
+        s -> clause_size  = realloc(s -> clause_size,
+                                    s -> clause_capacity *
+                                    sizeof(unsigned int));
+    }
+
+    unsigned int tr = s -> clause_count ++;
+
+    s -> clause_start[tr] = s -> lits_length;
+    s -> clause_size [tr] = size;
+    memcpy(&s -> lits[s -> lits_length], lits, size * sizeof(sat_lit));
+    s -> lits_length += size;
+
+    if(size > 1) {
+        sat_watch(s, lits[0], tr);
+        sat_watch(s, lits[1], tr);
+    }
+
+    s -> stats.learnt += 1;
+    return tr;
+}
+
+
+// ---------------------------------------------------------------------------
+// Propagation.
+
+/*!
+@brief Revise one relation, recording any values it implies.
+@returns SAT_FALSE if the relation has no support left. The domains are
+left as they were before the revision in that case.
+*/
+static t_sat_bool sat_search_revise(
+    sat_search_state * s,
+    sat_var_idx        rel
+){
+    sat_imp_matrix * imp_mat = s -> imp_mat;
+    sat_relation     r       = imp_mat -> relations[rel];
+    sat_var_idx      vars[3] = {rel, r.lhs, r.rhs};
+    t_sat_bool       old [3];
+    int              i;
+
+    for(i = 0; i < 3; i += 1) {
+        old[i] = sat_get_domain_bits(imp_mat, vars[i]);
+    }
+
+    if(!sat_solve_arc_reduce(imp_mat, rel)) {
+        return SAT_TRUE;
+    }
+
+    if(sat_domain_empty(imp_mat, rel)) {
+        for(i = 2; i >= 0; i -= 1) {
+            sat_set_domain_bits(imp_mat, vars[i], old[i]);
+        }
+        return SAT_FALSE;
+    }
+
+    // Every domain which changed went from both values to one. The same
+    // variable may appear more than once, but is only recorded once.
+    for(i = 0; i < 3; i += 1) {
+        t_sat_bool now = sat_get_domain_bits(imp_mat, vars[i]);
+
+        if(old[i] == SAT_DOMAIN_ALL && now != SAT_DOMAIN_ALL &&
+           (i < 1 || vars[i] != vars[0]) && (i < 2 || vars[i] != vars[1])) {
+            sat_search_assign(s, SAT_LIT(vars[i], now == SAT_DOMAIN_1),
+                              SAT_REASON_RELATION, rel);
+            s -> stats.propagations += 1;
+        }
+    }
+
+    return SAT_TRUE;
+}
+
+
+/*!
+@brief Visit the learnt clauses watching a literal which has become false.
+@param [out] conflict - Set to the clause which became false, if any.
+@returns SAT_FALSE if a clause became false.
+*/
+static t_sat_bool sat_search_propagate_clauses(
+    sat_search_state * s,
+    sat_lit            false_lit,
+    unsigned int     * conflict
+){
+    sat_watch_list * w  = &s -> watches[false_lit];
+    unsigned int     i  = 0;
+    unsigned int     j  = 0;
+    t_sat_bool       tr = SAT_TRUE;
+
+    while(i < w -> count) {
+
+        unsigned int c    = w -> items[i ++];
+        sat_lit    * lits = &s -> lits[s -> clause_start[c]];
+        unsigned int size = s -> clause_size[c];
+        unsigned int k;
+
+        // Keep the false literal in position 1.
+        if(lits[0] == false_lit) {
+            lits[0] = lits[1];
+            lits[1] = false_lit;
+        }
+
+        if(sat_lit_value(s, lits[0]) == 1) {
+            w -> items[j ++] = c;
+            continue;
+        }
+
+        // Look for another literal to watch.
+        for(k = 2; k < size; k += 1) {
+            if(sat_lit_value(s, lits[k]) != 0) {
+                lits[1] = lits[k];
+                lits[k] = false_lit;
+                sat_watch(s, lits[1], c);
+                break;
+            }
+        }
+
+        if(k < size) {
+            continue;
+        }
+
+        w -> items[j ++] = c;
+
+        if(sat_lit_value(s, lits[0]) == 0) {
+            *conflict = c;
+            tr        = SAT_FALSE;
+            while(i < w -> count) {
+                w -> items[j ++] = w -> items[i ++];
+            }
+        } else {
+            sat_search_assign(s, lits[0], SAT_REASON_CLAUSE, c);
+            s -> stats.propagations += 1;
+        }
+    }
+
+    w -> count = j;
+    return tr;
+}
+
+
+/*!
+@brief Propagate every value on the trail which has not been propagated
+yet, through the learnt clauses and the relations.
+@param [out] kind - Set to SAT_REASON_RELATION or SAT_REASON_CLAUSE on a
+conflict.
+@param [out] conflict - Set to the relation or clause in conflict.
+@returns SAT_FALSE on a conflict.
+*/
+static t_sat_bool sat_search_propagate(
+    sat_search_state * s,
+    unsigned char    * kind,
+    unsigned int     * conflict
+){
+    sat_imp_matrix * imp_mat = s -> imp_mat;
+
+    while(s -> queue_head < s -> trail_length) {
+
+        sat_var_idx v         = s -> trail[s -> queue_head ++];
+        sat_lit     false_lit = SAT_LIT(v, !sat_search_value(s, v));
+
+        if(!sat_search_propagate_clauses(s, false_lit, conflict)) {
+            *kind = SAT_REASON_CLAUSE;
+            return SAT_FALSE;
+        }
+
+        if(!sat_is_input(imp_mat, v) && !sat_search_revise(s, v)) {
+            *kind     = SAT_REASON_RELATION;
+            *conflict = v;
+            return SAT_FALSE;
+        }
+
+        unsigned int f   = imp_mat -> fanout_start[v    ];
+        unsigned int end = imp_mat -> fanout_start[v + 1];
+
+        for(; f < end; f += 1) {
+            if(!sat_search_revise(s, imp_mat -> fanout[f])) {
+                *kind     = SAT_REASON_RELATION;
+                *conflict = imp_mat -> fanout[f];
+                return SAT_FALSE;
+            }
+        }
+    }
+
+    return SAT_TRUE;
+}
+
+
+// ---------------------------------------------------------------------------
+// Conflict analysis.
+
+/*!
+@brief Collect the variables whose values explain a conflict or an implied
+value.
+@details For a relation these are its participants which were set before
+`before` on the trail. For a clause they are its literals, less the one
+which was implied.
+@param [out] vars - At least 3 entries, or as many as the longest clause.
+@returns The number of variables written to vars.
+*/
+static unsigned int sat_reason_vars(
+    sat_search_state * s,
+    unsigned char      kind,
+    unsigned int       reason,
+    unsigned int       before,
+    sat_var_idx      * vars
+){
+    unsigned int tr = 0;
+    unsigned int i;
+
+    if(kind == SAT_REASON_RELATION) {
+
+        sat_relation r = s -> imp_mat -> relations[reason];
+        sat_var_idx  p[3] = {reason, r.lhs, r.rhs};
+
+        for(i = 0; i < 3; i += 1) {
+            if((i < 1 || p[i] != p[0]) && (i < 2 || p[i] != p[1]) &&
+               sat_search_assigned(s, p[i]) &&
+               s -> trail_pos[p[i]] < before) {
+                vars[tr ++] = p[i];
+            }
+        }
+
+    } else {
+
+        sat_lit * lits = &s -> lits[s -> clause_start[reason]];
+
+        for(i = 0; i < s -> clause_size[reason]; i += 1) {
+            if(s -> trail_pos[SAT_LIT_VAR(lits[i])] < before) {
+                vars[tr ++] = SAT_LIT_VAR(lits[i]);
+            }
+        }
+    }
+
+    return tr;
+}
+
+
+/*!
+@brief Work out a clause explaining a conflict, by resolving back to the
+first unique implication point at the current level.
+@details The asserting literal ends up in learnt[0] and the literal from
+the highest remaining level in learnt[1].
+@param [out] backjump - The level to go back to before asserting the clause.
+@returns The number of literals in the learnt clause.
+*/
+static unsigned int sat_analyse(
+    sat_search_state * s,
+    unsigned char      kind,
+    unsigned int       conflict,
+    unsigned int     * backjump
+){
+    sat_var_idx * vars       = s -> learnt + s -> n;
+    unsigned int  size       = 1;
+    unsigned int  open_paths = 0;
+    unsigned int  index      = s -> trail_length;
+    unsigned int  before     = s -> trail_length;
+    sat_var_idx   pivot;
+    unsigned int  i;
+
+    do {
+        unsigned int count = sat_reason_vars(s, kind, conflict, before, vars);
+
+        for(i = 0; i < count; i += 1) {
+            sat_var_idx q = vars[i];
+
+            if(s -> seen[q] || s -> var_level[q] == 0) continue;
+
+            s -> seen[q] = SAT_TRUE;
+            sat_bump_activity(s, q);
+
+            if(s -> var_level[q] >= s -> level) {
+                open_paths += 1;
+            } else {
+                s -> learnt[size ++] = SAT_LIT(q, !sat_search_value(s, q));
+            }
+        }
+
+        // Walk back to the next variable involved in the conflict.
+        do {
+            pivot = s -> trail[-- index];
+        } while(!s -> seen[pivot]);
+
+        s -> seen[pivot] = SAT_FALSE;
+        open_paths      -= 1;
+        kind             = s -> reason_kind[pivot];
+        conflict         = s -> reason     [pivot];
+        before           = s -> trail_pos  [pivot];
+
+    } while(open_paths > 0);
+
+    s -> learnt[0] = SAT_LIT(pivot, !sat_search_value(s, pivot));
+
+    // Put the literal from the highest level second so it is watched.
+    *backjump = 0;
+    for(i = 1; i < size; i += 1) {
+        sat_var_idx q = SAT_LIT_VAR(s -> learnt[i]);
+
+        s -> seen[q] = SAT_FALSE;
+
+        if(s -> var_level[q] > *backjump) {
+            sat_lit t = s -> learnt[1];
+            s -> learnt[1] = s -> learnt[i];
+            s -> learnt[i] = t;
+            *backjump = s -> var_level[q];
+        }
+    }
+
+    s -> activity_inc /= SAT_ACTIVITY_DECAY;
+    return size;
+}
+
+
+/*!
+@brief The i'th term of the Luby sequence, 1 1 2 1 1 2 4 1 1 2 ...
+*/
+static unsigned long sat_luby(
+    unsigned long i
+){
+    unsigned long size = 1;
+    unsigned long seq  = 0;
+
+    while(size < i + 1) {
+        seq  += 1;
+        size  = 2 * size + 1;
+    }
+
+    while(size - 1 != i) {
+        size = (size - 1) >> 1;
+        seq -= 1;
+        i    = i % size;
+    }
+
+    return 1ul << seq;
+}
+
+
+// ---------------------------------------------------------------------------
+
+/*!
+@brief Decide whether the constraint problem has a solution, and find one.
+@details Values already fixed in the matrix are treated as level 0 facts.
+Every relation is revised once at level 0 before the first decision.
+@param [inout] imp_mat - The matrix to search.
+@param [out] stats - If not NULL, filled in with counters for the search.
+@returns SAT_TRUE if a satisfying assignment was found, SAT_FALSE if the
+problem has none.
+*/
+t_sat_bool sat_search(
+    sat_imp_matrix   * imp_mat,
+    sat_search_stats * stats
+){
+    assert(imp_mat != NULL);
+
+    if(imp_mat -> fanout_stale) {
+        sat_build_fanout(imp_mat);
+    }
+
+    sat_search_state s;
+    unsigned int     n = imp_mat -> variable_count;
+    unsigned int     i;
+
+    memset(&s, 0, sizeof(s));
+    s.imp_mat      = imp_mat;
+    s.n            = n;
+    s.activity_inc = 1;
+
+    s.trail        = calloc(n + 1, sizeof(sat_var_idx));
+    s.level_start  = calloc(n + 2, sizeof(unsigned int));
+    s.var_level    = calloc(n + 1, sizeof(unsigned int));
+    s.trail_pos    = calloc(n + 1, sizeof(unsigned int));
+    s.reason       = calloc(n + 1, sizeof(unsigned int));
+    s.reason_kind  = calloc(n + 1, sizeof(unsigned char));
+    s.seen         = calloc(n + 1, sizeof(unsigned char));
+    s.phase        = calloc(n + 1, sizeof(unsigned char));
+    s.activity     = calloc(n + 1, sizeof(double));
+    s.heap         = calloc(n + 1, sizeof(sat_var_idx));
+    s.heap_pos     = calloc(n + 1, sizeof(int));
+    s.watches      = calloc(2 * n + 2, sizeof(sat_watch_list));
+    s.learnt       = calloc(2 * n + 2, sizeof(sat_lit));
+
+    // -1 until we know the answer.
+    int           tr = sat_any_domain_empty(imp_mat) ? SAT_FALSE : -1;
+    unsigned char kind;
+    unsigned int  conflict;
+
+    // Values fixed before the search are level 0 facts.
+    for(i = 0; i < n; i += 1) {
+        s.heap_pos[i] = -1;
+        if(sat_search_assigned(&s, i)) {
+            sat_search_assign(&s, SAT_LIT(i, sat_search_value(&s, i)),
+                              SAT_REASON_NONE, 0);
+        }
+    }
+
+    for(i = 0; i < n && tr == -1; i += 1) {
+        if(!sat_is_input(imp_mat, i) && !sat_search_revise(&s, i)) {
+            tr = SAT_FALSE;
+        }
+    }
+
+    if(tr == -1 && !sat_search_propagate(&s, &kind, &conflict)) {
+        tr = SAT_FALSE;
+    }
+
+    for(i = 0; i < n; i += 1) {
+        if(!sat_search_assigned(&s, i)) {
+            sat_heap_insert(&s, i);
+        }
+    }
+
+    unsigned long restart_count  = 0;
+    unsigned long conflict_limit = SAT_RESTART_UNIT;
+
+    while(tr == -1) {
+
+        if(!sat_search_propagate(&s, &kind, &conflict)) {
+
+            s.stats.conflicts += 1;
+
+            if(s.level == 0) {
+                tr = SAT_FALSE;
+                break;
+            }
+
+            unsigned int backjump;
+            unsigned int size = sat_analyse(&s, kind, conflict, &backjump);
+
+            sat_search_backtrack(&s, backjump);
+
+            if(size == 1) {
+                sat_search_assign(&s, s.learnt[0], SAT_REASON_NONE, 0);
+            } else {
+                unsigned int c = sat_add_clause(&s, s.learnt, size);
+                sat_search_assign(&s, s.learnt[0], SAT_REASON_CLAUSE, c);
+            }
+
+            if(conflict_limit > 0) {
+                conflict_limit -= 1;
+            }
+            continue;
+        }
+
+        if(conflict_limit == 0) {
+            restart_count  += 1;
+            conflict_limit  = SAT_RESTART_UNIT * sat_luby(restart_count);
+            s.stats.restarts += 1;
+            sat_search_backtrack(&s, 0);
+            continue;
+        }
+
+        // Find the best variable which still has both values.
+        sat_var_idx next = n;
+        while(s.heap_size > 0) {
+            next = sat_heap_pop(&s);
+            if(!sat_search_assigned(&s, next)) break;
+            next = n;
+        }
+
+        if(next == n) {
+            tr = SAT_TRUE;
+            break;
+        }
+
+        s.stats.decisions += 1;
+        s.level += 1;
+        s.level_start[s.level] = s.trail_length;
+        sat_search_assign(&s, SAT_LIT(next, s.phase[next]),
+                          SAT_REASON_NONE, 0);
+    }
+
+    if(tr == SAT_FALSE) {
+        sat_search_backtrack(&s, 0);
+    }
+
+    if(stats != NULL) {
+        *stats = s.stats;
+    }
+
+    for(i = 0; i < 2 * n + 2; i += 1) {
+        free(s.watches[i].items);
+    }
+
+    free(s.trail);
+    free(s.level_start);
+    free(s.var_level);
+    free(s.trail_pos);
+    free(s.reason);
+    free(s.reason_kind);
+    free(s.seen);
+    free(s.phase);
+    free(s.activity);
+    free(s.heap);
+    free(s.heap_pos);
+    free(s.watches);
+    free(s.learnt);
+    free(s.lits);
+    free(s.clause_start);
+    free(s.clause_size);
+
+    return tr;
+}
+
+
+/*!
+@brief Check that the domains of a matrix form a satisfying assignment.
+@details Independent of the search itself, so it catches a search which
+claims a model it has not really found.
+@param [in] imp_mat - The matrix to check.
+@returns SAT_TRUE if every domain holds exactly one value and every
+relation holds for those values.
+*/
+t_sat_bool sat_check_model(
+    sat_imp_matrix * imp_mat
+){
+    assert(imp_mat != NULL);
+
+    sat_var_idx v;
+
+    for(v = 0; v < imp_mat -> variable_count; v += 1) {
+        t_sat_bool bits = sat_get_domain_bits(imp_mat, v);
+
+        if(bits != SAT_DOMAIN_0 && bits != SAT_DOMAIN_1) {
+            return SAT_FALSE;
+        }
+    }
+
+    for(v = 0; v < imp_mat -> variable_count; v += 1) {
+        sat_relation * r     = &imp_mat -> relations[v];
+        unsigned short truth = sat_relation_truth(r);
+
+        if(truth == SAT_OP_UNCONSTRAINED) continue;
+
+        t_sat_bool l = sat_get_domain_bits(imp_mat, r -> lhs) >> 1;
+        t_sat_bool x = sat_get_domain_bits(imp_mat, r -> rhs) >> 1;
+
+        if(((truth >> (2 * l + x)) & 1) !=
+           sat_get_domain_bits(imp_mat, v) >> 1) {
+            return SAT_FALSE;
+        }
+    }
+
+    return SAT_TRUE;
+}
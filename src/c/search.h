@@ -0,0 +1,74 @@
+
+#include "imp-matrix.h"
+
+#ifndef H_SEARCH
+#define H_SEARCH
+
+/*!
+@defgroup gr-search Search
+
+@brief Complete CDCL search using the relations of a matrix as the
+propagator.
+
+@details Arc consistency alone can leave variables undetermined without
+telling us whether the problem is really satisfiable. The search engine
+decides values for undetermined variables, inputs first, and propagates
+each decision through the relations exactly as sat_solve does. Every value
+which propagation removes is recorded on a trail so it can be undone.
+
+When a relation empties a domain, the conflict is analysed back to the
+first unique implication point and the resulting clause is learnt. Learnt
+clauses are propagated with two watched literals alongside the relations.
+The reason for a value implied by a relation is simply the values of its
+other participants which were set before it.
+
+Decisions pick the most active variable (VSIDS) and try the value it last
+had. The search restarts on the Luby sequence.
+
+@addtogroup gr-search
+@{
+*/
+
+/*!
+@brief Counters describing the work done by sat_search.
+*/
+typedef struct sat_search_stats_t {
+    unsigned long decisions;    //!< Values chosen by the search.
+    unsigned long propagations; //!< Values implied by relations or clauses.
+    unsigned long conflicts;    //!< Conflicts analysed.
+    unsigned long learnt;       //!< Clauses learnt from conflicts.
+    unsigned long restarts;     //!< Times the search went back to level 0.
+} sat_search_stats;
+
+
+/*!
+@brief Decide whether the constraint problem has a solution, and find one.
+@details On success every domain in the matrix holds exactly one value,
+which together form a satisfying assignment. Otherwise the domains are left
+as they were after propagating the constraints, before any decisions.
+@param [inout] imp_mat - The matrix to search.
+@param [out] stats - If not NULL, filled in with counters for the search.
+@returns SAT_TRUE if a satisfying assignment was found, SAT_FALSE if the
+problem has none.
+*/
+t_sat_bool sat_search(
+    sat_imp_matrix   * imp_mat,
+    sat_search_stats * stats
+);
+
+
+/*!
+@brief Check that the domains of a matrix form a satisfying assignment.
+@details Used to check the model found by sat_search against the relations
+it was given.
+@param [in] imp_mat - The matrix to check.
+@returns SAT_TRUE if every domain holds exactly one value and every
+relation holds for those values.
+*/
+t_sat_bool sat_check_model(
+    sat_imp_matrix * imp_mat
+);
+
+/*! @} */
+
+#endif
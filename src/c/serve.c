@@ -0,0 +1,601 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "serve.h"
+#include "sat-expression.h"
+
+//! Most terms a single query may hold.
+#define SAT_SERVE_MAX_TERMS 256
+
+/*!
+@brief One loaded circuit, and the incremental solver which answers queries
+about it.
+*/
+typedef struct sat_circuit_t {
+    sat_context     * ctx;        //!< The parsed circuit.
+    sat_incremental * inc;        //!< Answers queries from its base state.
+    pthread_mutex_t   lock;       //!< Held for the whole of each query.
+    unsigned int      references; //!< Requests using it. Guarded by server.
+    t_sat_bool        unloaded;   //!< Free once the last request finishes.
+} sat_circuit;
+
+
+/*!
+@brief Everything shared by the clients of one server.
+*/
+struct t_sat_server {
+    pthread_mutex_t   lock;             //!< Guards every field below.
+    pthread_cond_t    idle;             //!< Signalled as clients disconnect.
+    sat_circuit    ** circuits;         //!< Loaded circuits, by handle.
+    unsigned int      circuit_count;    //!< Handles given out so far.
+    unsigned int      circuit_capacity; //!< Number of handles allocated.
+    unsigned int      clients;          //!< Socket clients connected.
+    int               listener;         //!< Listening socket, or -1.
+    unsigned long     requests;         //!< Requests answered.
+    unsigned long     queries;          //!< Queries answered.
+    double            query_total_us;   //!< Time spent answering queries.
+    double            query_max_us;     //!< Slowest query.
+};
+
+
+/*!
+@brief Create a new server with no circuits loaded.
+@returns A pointer to the server, to be freed with sat_free_server.
+*/
+sat_server * sat_new_server()
+{
+    sat_server * tr = calloc(1, sizeof(sat_server));
+    pthread_mutex_init(&tr -> lock, NULL);
+    pthread_cond_init(&tr -> idle, NULL);
+    tr -> listener = -1;
+    return tr;
+}
+
+
+/*!
+@brief Free a circuit and its context.
+@param [in] tofree - The circuit to free.
+*/
+static void sat_free_circuit(
+    sat_circuit * tofree
+){
+    sat_free_incremental(tofree -> inc);
+    sat_free_context(tofree -> ctx);
+    pthread_mutex_destroy(&tofree -> lock);
+    free(tofree);
+}
+
+
+/*!
+@brief Free a server and every circuit loaded into it.
+@param [in] tofree - The server to free.
+*/
+void sat_free_server(
+    sat_server * tofree
+){
+    unsigned int i;
+    for(i = 0; i < tofree -> circuit_count; i += 1) {
+        if(tofree -> circuits[i] != NULL) {
+            sat_free_circuit(tofree -> circuits[i]);
+        }
+    }
+    free(tofree -> circuits);
+    pthread_cond_destroy(&tofree -> idle);
+    pthread_mutex_destroy(&tofree -> lock);
+    free(tofree);
+}
+
+
+//! Returns a monotonic time stamp in microseconds.
+static double sat_serve_now_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+
+/*!
+@brief Take a reference to a loaded circuit, so it is not freed while in
+use.
+@param [inout] server - The server holding the circuit.
+@param [in] handle - The text of the handle from the request.
+@returns The circuit, or NULL if there is no such handle.
+*/
+static sat_circuit * sat_serve_acquire(
+    sat_server * server,
+    const char * handle
+){
+    char        * end;
+    unsigned long index = handle ? strtoul(handle, &end, 10) : 0;
+    sat_circuit * tr    = NULL;
+
+    if(handle == NULL || *end != '\0') {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&server -> lock);
+    if(index < server -> circuit_count && server -> circuits[index] != NULL) {
+        tr = server -> circuits[index];
+        tr -> references += 1;
+    }
+    pthread_mutex_unlock(&server -> lock);
+
+    return tr;
+}
+
+
+/*!
+@brief Drop a reference taken by sat_serve_acquire, freeing the circuit if
+it has been unloaded and this was the last reference.
+@param [inout] server - The server holding the circuit.
+@param [in] circuit - The circuit to release.
+*/
+static void sat_serve_release(
+    sat_server  * server,
+    sat_circuit * circuit
+){
+    pthread_mutex_lock(&server -> lock);
+    circuit -> references -= 1;
+    t_sat_bool dead = circuit -> unloaded && circuit -> references == 0;
+    pthread_mutex_unlock(&server -> lock);
+
+    if(dead) {
+        sat_free_circuit(circuit);
+    }
+}
+
+
+/*!
+@brief Handle a `load` request.
+@param [inout] server - The server to load into.
+@param [in] path - The file to load.
+@param [in] output - Where to write the reply.
+*/
+static void sat_serve_load(
+    sat_server * server,
+    const char * path,
+    FILE       * output
+){
+    if(path == NULL) {
+        fprintf(output, "error missing path\n");
+        return;
+    }
+
+    sat_context * ctx    = sat_new_context();
+    int           result = sat_load_file(ctx, path);
+
+    if(result != SAT_LOAD_OK) {
+        fprintf(output, result == SAT_LOAD_UNREADABLE ?
+                        "error could not open '%s'\n" :
+                        "error syntax error in '%s'\n", path);
+        sat_free_context(ctx);
+        return;
+    }
+
+    sat_circuit * circuit = calloc(1, sizeof(sat_circuit));
+    circuit -> ctx = ctx;
+    circuit -> inc = sat_new_incremental(sat_get_imp_matrix(ctx));
+    pthread_mutex_init(&circuit -> lock, NULL);
+
+    t_sat_bool consistent = sat_incremental_settle(circuit -> inc);
+
+    pthread_mutex_lock(&server -> lock);
+    if(server -> circuit_count == server -> circuit_capacity) {
+        server -> circuit_capacity = server -> circuit_capacity ?
+                                     server -> circuit_capacity * 2 : 16;
+        server -> circuits = realloc(server -> circuits,
+                                     server -> circuit_capacity *
+                                     sizeof(sat_circuit*));
+    }
+    unsigned int handle = server -> circuit_count ++;
+    server -> circuits[handle] = circuit;
+    pthread_mutex_unlock(&server -> lock);
+
+    fprintf(output, "ok %u variables=%u %s\n", handle,
+            sat_get_variable_count(ctx),
+            consistent ? "consistent" : "conflict");
+}
+
+
+/*!
+@brief Handle an `unload` request.
+@param [inout] server - The server to unload from.
+@param [in] handle - The text of the handle from the request.
+@param [in] output - Where to write the reply.
+*/
+static void sat_serve_unload(
+    sat_server * server,
+    const char * handle,
+    FILE       * output
+){
+    sat_circuit * circuit = sat_serve_acquire(server, handle);
+
+    if(circuit == NULL) {
+        fprintf(output, "error no such handle\n");
+        return;
+    }
+
+    pthread_mutex_lock(&server -> lock);
+    server -> circuits[strtoul(handle, NULL, 10)] = NULL;
+    circuit -> unloaded = SAT_TRUE;
+    pthread_mutex_unlock(&server -> lock);
+
+    sat_serve_release(server, circuit);
+    fprintf(output, "ok\n");
+}
+
+
+//! Prints a packed domain the way query expectations are written.
+static void sat_serve_print_domain(
+    FILE       * output,
+    const char * name,
+    t_sat_bool   bits
+){
+    fprintf(output, " %s={%s%s%s}", name,
+            bits & SAT_DOMAIN_0 ? "0" : "",
+            bits == SAT_DOMAIN_ALL ? "," : "",
+            bits & SAT_DOMAIN_1 ? "1" : "");
+}
+
+
+/*!
+@brief Handle a `query` request.
+@details Every term is checked before any of them is applied, so a badly
+formed query leaves the circuit untouched.
+@param [inout] server - The server to query.
+@param [in] handle - The text of the handle from the request.
+@param [inout] save - strtok_r state holding the rest of the request.
+@param [in] output - Where to write the reply.
+*/
+static void sat_serve_query(
+    sat_server * server,
+    const char * handle,
+    char      ** save,
+    FILE       * output
+){
+    sat_circuit * circuit = sat_serve_acquire(server, handle);
+
+    if(circuit == NULL) {
+        fprintf(output, "error no such handle\n");
+        return;
+    }
+
+    sat_var_idx  vars  [SAT_SERVE_MAX_TERMS];
+    t_sat_bool   bits  [SAT_SERVE_MAX_TERMS];
+    t_sat_bool   expect[SAT_SERVE_MAX_TERMS];
+    unsigned int count = 0;
+    char       * term;
+
+    while((term = strtok_r(NULL, " \t\r\n", save)) != NULL) {
+
+        char * op = strpbrk(term, "=!");
+
+        if(count == SAT_SERVE_MAX_TERMS || op == NULL || op == term) {
+            fprintf(output, "error bad term '%s'\n", term);
+            sat_serve_release(server, circuit);
+            return;
+        }
+
+        if(op[0] == '!' && op[1] == '=' && (op[2] == '0' || op[2] == '1') &&
+           op[3] == '\0') {
+            expect[count] = SAT_FALSE;
+            bits  [count] = op[2] == '0' ? SAT_DOMAIN_1 : SAT_DOMAIN_0;
+        } else if(op[0] == '=' && op[1] == '=' &&
+                  (op[2] == '0' || op[2] == '1') && op[3] == '\0') {
+            expect[count] = SAT_FALSE;
+            bits  [count] = op[2] == '0' ? SAT_DOMAIN_0 : SAT_DOMAIN_1;
+        } else if(strcmp(op, "={}") == 0) {
+            expect[count] = SAT_TRUE;
+            bits  [count] = 0;
+        } else if(strcmp(op, "={0}") == 0) {
+            expect[count] = SAT_TRUE;
+            bits  [count] = SAT_DOMAIN_0;
+        } else if(strcmp(op, "={1}") == 0) {
+            expect[count] = SAT_TRUE;
+            bits  [count] = SAT_DOMAIN_1;
+        } else if(strcmp(op, "={0,1}") == 0) {
+            expect[count] = SAT_TRUE;
+            bits  [count] = SAT_DOMAIN_ALL;
+        } else {
+            fprintf(output, "error bad term '%s'\n", term);
+            sat_serve_release(server, circuit);
+            return;
+        }
+
+        char saved = *op;
+        *op = '\0';
+        t_sat_bool found = sat_find_variable(circuit -> ctx, term,
+                                             &vars[count]);
+        *op = saved;
+
+        if(!found) {
+            fprintf(output, "error unknown variable in '%s'\n", term);
+            sat_serve_release(server, circuit);
+            return;
+        }
+
+        count += 1;
+    }
+
+    pthread_mutex_lock(&circuit -> lock);
+
+    double           start   = sat_serve_now_us();
+    sat_imp_matrix * imp_mat = sat_get_imp_matrix(circuit -> ctx);
+    t_sat_bool       ok      = SAT_TRUE;
+    t_sat_bool       met     = SAT_TRUE;
+    unsigned int     i;
+
+    for(i = 0; i < count && ok; i += 1) {
+        if(!expect[i]) {
+            ok = sat_incremental_assume(circuit -> inc, vars[i],
+                                        bits[i] == SAT_DOMAIN_1);
+        }
+    }
+    if(ok) {
+        ok = sat_incremental_propagate(circuit -> inc);
+    }
+
+    for(i = 0; i < count; i += 1) {
+        if(expect[i] && sat_get_domain_bits(imp_mat, vars[i]) != bits[i]) {
+            met = SAT_FALSE;
+        }
+    }
+
+    double elapsed = sat_serve_now_us() - start;
+
+    fprintf(output, "ok %s %s %.1fus", ok ? "consistent" : "conflict",
+            met ? "met" : "not-met", elapsed);
+
+    for(i = 0; i < count; i += 1) {
+        t_sat_bool actual = sat_get_domain_bits(imp_mat, vars[i]);
+        if(expect[i] && actual != bits[i]) {
+            sat_serve_print_domain(output,
+                                   sat_get_variable_name(circuit -> ctx,
+                                                         vars[i]),
+                                   actual);
+        }
+    }
+    fprintf(output, "\n");
+
+    sat_incremental_rollback(circuit -> inc);
+    pthread_mutex_unlock(&circuit -> lock);
+    sat_serve_release(server, circuit);
+
+    pthread_mutex_lock(&server -> lock);
+    server -> queries        += 1;
+    server -> query_total_us += elapsed;
+    if(elapsed > server -> query_max_us) {
+        server -> query_max_us = elapsed;
+    }
+    pthread_mutex_unlock(&server -> lock);
+}
+
+
+/*!
+@brief Handle a `stats` request.
+@param [inout] server - The server to describe.
+@param [in] output - Where to write the reply.
+*/
+static void sat_serve_stats(
+    sat_server * server,
+    FILE       * output
+){
+    pthread_mutex_lock(&server -> lock);
+
+    unsigned int loaded = 0;
+    unsigned int i;
+    for(i = 0; i < server -> circuit_count; i += 1) {
+        loaded += server -> circuits[i] != NULL;
+    }
+
+    fprintf(output, "ok requests=%lu queries=%lu mean=%.1fus max=%.1fus "
+                    "circuits=%u clients=%u\n",
+            server -> requests,
+            server -> queries,
+            server -> queries ? server -> query_total_us / server -> queries
+                              : 0.0,
+            server -> query_max_us,
+            loaded,
+            server -> clients);
+
+    pthread_mutex_unlock(&server -> lock);
+}
+
+
+/*!
+@brief Answer requests read from one stream until it ends, or the client
+sends `quit` or `shutdown`.
+@param [inout] server - The server to answer from.
+@param [in] input - The stream of requests.
+@param [in] output - The stream to write replies to.
+@returns SAT_TRUE if the client asked the server to shut down.
+*/
+t_sat_bool sat_serve_stream(
+    sat_server * server,
+    FILE       * input,
+    FILE       * output
+){
+    char     * line     = NULL;
+    size_t     size     = 0;
+    t_sat_bool shutdown = SAT_FALSE;
+
+    while(getline(&line, &size, input) > 0) {
+
+        char * save;
+        char * command = strtok_r(line, " \t\r\n", &save);
+
+        if(command == NULL) {
+            continue;
+        }
+
+        pthread_mutex_lock(&server -> lock);
+        server -> requests += 1;
+        pthread_mutex_unlock(&server -> lock);
+
+        if(strcmp(command, "query") == 0) {
+            char * handle = strtok_r(NULL, " \t\r\n", &save);
+            sat_serve_query(server, handle, &save, output);
+        } else if(strcmp(command, "load") == 0) {
+            sat_serve_load(server, strtok_r(NULL, " \t\r\n", &save), output);
+        } else if(strcmp(command, "unload") == 0) {
+            sat_serve_unload(server, strtok_r(NULL, " \t\r\n", &save),
+                             output);
+        } else if(strcmp(command, "stats") == 0) {
+            sat_serve_stats(server, output);
+        } else if(strcmp(command, "quit") == 0) {
+            fprintf(output, "ok\n");
+            break;
+        } else if(strcmp(command, "shutdown") == 0) {
+            fprintf(output, "ok\n");
+            shutdown = SAT_TRUE;
+            break;
+        } else {
+            fprintf(output, "error unknown command '%s'\n", command);
+        }
+
+        fflush(output);
+    }
+
+    fflush(output);
+    free(line);
+    return shutdown;
+}
+
+
+//! Arguments passed to the thread serving one socket client.
+typedef struct sat_serve_client_t {
+    sat_server * server; //!< The server to answer from.
+    int          socket; //!< The connected socket.
+} sat_serve_client;
+
+
+/*!
+@brief Thread body answering one socket client.
+@param [in] arg - A sat_serve_client, which is freed.
+@returns NULL.
+*/
+static void * sat_serve_client_thread(
+    void * arg
+){
+    sat_serve_client * client = arg;
+    sat_server       * server = client -> server;
+
+    FILE * input  = fdopen(client -> socket, "r");
+    FILE * output = fdopen(dup(client -> socket), "w");
+
+    if(input != NULL && output != NULL &&
+       sat_serve_stream(server, input, output)) {
+        // Wake the accept loop, which then waits for everyone else.
+        pthread_mutex_lock(&server -> lock);
+        if(server -> listener >= 0) {
+            shutdown(server -> listener, SHUT_RDWR);
+        }
+        pthread_mutex_unlock(&server -> lock);
+    }
+
+    if(input  != NULL) fclose(input);
+    if(output != NULL) fclose(output);
+    free(client);
+
+    pthread_mutex_lock(&server -> lock);
+    server -> clients -= 1;
+    pthread_cond_broadcast(&server -> idle);
+    pthread_mutex_unlock(&server -> lock);
+
+    return NULL;
+}
+
+
+/*!
+@brief Listen on a Unix domain socket, and answer each client which
+connects on a thread of its own.
+@param [inout] server - The server to answer from.
+@param [in] path - Where to create the socket.
+@returns 0 on a clean shutdown, or 1 if the socket could not be created.
+*/
+int sat_serve_socket(
+    sat_server * server,
+    const char * path
+){
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if(strlen(path) >= sizeof(address.sun_path)) {
+        return 1;
+    }
+    strcpy(address.sun_path, path);
+
+    // A client which hangs up early must not take the server down with it.
+    signal(SIGPIPE, SIG_IGN);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener < 0) {
+        return 1;
+    }
+
+    unlink(path);
+    if(bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+       listen(listener, 64) != 0) {
+        close(listener);
+        return 1;
+    }
+
+    pthread_mutex_lock(&server -> lock);
+    server -> listener = listener;
+    pthread_mutex_unlock(&server -> lock);
+
+    while(SAT_TRUE) {
+
+        int connection = accept(listener, NULL, NULL);
+
+        if(connection < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        sat_serve_client * client = malloc(sizeof(sat_serve_client));
+        client -> server = server;
+        client -> socket = connection;
+
+        pthread_mutex_lock(&server -> lock);
+        server -> clients += 1;
+        pthread_mutex_unlock(&server -> lock);
+
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, sat_serve_client_thread, client)) {
+            close(connection);
+            free(client);
+            pthread_mutex_lock(&server -> lock);
+            server -> clients -= 1;
+            pthread_mutex_unlock(&server -> lock);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+
+    pthread_mutex_lock(&server -> lock);
+    server -> listener = -1;
+    while(server -> clients > 0) {
+        pthread_cond_wait(&server -> idle, &server -> lock);
+    }
+    pthread_mutex_unlock(&server -> lock);
+
+    close(listener);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,96 @@
+
+#include <stdio.h>
+
+#include "sats.h"
+
+#ifndef H_SERVE
+#define H_SERVE
+
+/*!
+@defgroup gr-serve Solver Daemon
+
+@brief Answer queries about loaded circuits from a long running process.
+
+@details A server holds any number of circuits, each parsed into its own
+context and propagated to its base state once, when it is loaded. Queries
+then narrow a few domains with unary constraints, check expectations and
+roll back, using the incremental solver, so they cost time in proportion to
+what they change rather than to the size of the circuit.
+
+Requests are single lines of text, and each gets exactly one line back, in
+the order the requests were sent. Clients may send many requests before
+reading any replies.
+
+    load <path>                   ok <handle> variables=<n> <state>
+    query <handle> <term> ...     ok <state> <met|not-met> <t>us [<var>=<d>...]
+    unload <handle>               ok
+    stats                         ok requests=<n> queries=<n> mean=<t>us ...
+    quit                          ok, and the connection is closed.
+    shutdown                      ok, and the server stops accepting clients.
+
+A query term is either a unary constraint, `a==0`, `a==1`, `a!=0` or
+`a!=1`, or an expectation on the domain of a variable, `a={}`, `a={0}`,
+`a={1}` or `a={0,1}`. The state is `consistent` or `conflict`. The actual
+domains of any variables which did not meet their expectations follow the
+timing. Failed requests are answered with `error <reason>`.
+
+Circuits are shared between clients. Queries on different circuits run at
+the same time, while queries on the same circuit take turns.
+
+@addtogroup gr-serve
+@{
+*/
+
+//! Opaque handle to the circuits and statistics of one server.
+typedef struct t_sat_server sat_server;
+
+
+/*!
+@brief Create a new server with no circuits loaded.
+@returns A pointer to the server, to be freed with sat_free_server.
+*/
+sat_server * sat_new_server();
+
+
+/*!
+@brief Free a server and every circuit loaded into it.
+@details No client may still be connected.
+@param [in] tofree - The server to free.
+*/
+void sat_free_server(
+    sat_server * tofree
+);
+
+
+/*!
+@brief Answer requests read from one stream until it ends, or the client
+sends `quit` or `shutdown`.
+@param [inout] server - The server to answer from.
+@param [in] input - The stream of requests.
+@param [in] output - The stream to write replies to.
+@returns SAT_TRUE if the client asked the server to shut down.
+*/
+t_sat_bool sat_serve_stream(
+    sat_server * server,
+    FILE       * input,
+    FILE       * output
+);
+
+
+/*!
+@brief Listen on a Unix domain socket, and answer each client which
+connects on a thread of its own.
+@details Returns once a client sends `shutdown` and every other client has
+disconnected. The socket file is removed before returning.
+@param [inout] server - The server to answer from.
+@param [in] path - Where to create the socket.
+@returns 0 on a clean shutdown, or 1 if the socket could not be created.
+*/
+int sat_serve_socket(
+    sat_server * server,
+    const char * path
+);
+
+/*! @} */
+
+#endif
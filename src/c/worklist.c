@@ -0,0 +1,97 @@
+
+#include <assert.h>
+
+#include "worklist.h"
+
+//! Index of the byte in the pending bitmap which holds the bit for i.
+#define WORKLIST_BYTE(i) ((i) >> 3)
+
+//! Mask selecting the bit for i within its pending bitmap byte.
+#define WORKLIST_BIT(i)  (1 << ((i) & 0x7))
+
+
+/*!
+@brief Create a new empty worklist able to hold indexes 0..capacity-1.
+@param [in] capacity - One more than the largest index to be stored.
+@returns a new empty worklist.
+*/
+worklist * worklist_new(
+    unsigned int capacity
+){
+    worklist * tr = calloc(1, sizeof(worklist));
+
+    tr -> items    = calloc(capacity > 0 ? capacity : 1,
+                            sizeof(unsigned int));
+    tr -> pending  = calloc((capacity >> 3) + 1, sizeof(unsigned char));
+    tr -> capacity = capacity;
+    tr -> head     = 0;
+    tr -> length   = 0;
+
+    return tr;
+}
+
+
+/*!
+@brief Free the memory allocated for a worklist.
+@param [in] tofree - The worklist to free.
+*/
+void worklist_free(
+    worklist * tofree
+){
+    free(tofree -> items);
+    free(tofree -> pending);
+    free(tofree);
+}
+
+
+/*!
+@brief Add an index to the back of the worklist.
+@details Does nothing if the index is already pending.
+@param [in] w - The worklist to append to.
+@param [in] toadd - The index to add to the worklist.
+*/
+void worklist_enqueue(
+    worklist    * w,
+    unsigned int  toadd
+){
+    assert(toadd < w -> capacity);
+
+    if(w -> pending[WORKLIST_BYTE(toadd)] & WORKLIST_BIT(toadd)) {
+        return;
+    }
+
+    w -> pending[WORKLIST_BYTE(toadd)] |= WORKLIST_BIT(toadd);
+
+    unsigned int tail = w -> head + w -> length;
+    if(tail >= w -> capacity) {
+        tail -= w -> capacity;
+    }
+
+    w -> items[tail] = toadd;
+    w -> length     += 1;
+}
+
+
+/*!
+@brief Remove and return the index at the front of the worklist.
+@warning Must not be called on an empty worklist.
+@param [in] w - The worklist to remove things from.
+*/
+unsigned int worklist_dequeue(
+    worklist * w
+){
+    assert(w -> length > 0);
+
+    unsigned int tr = w -> items[w -> head];
+
+    w -> head   += 1;
+    w -> length -= 1;
+
+    if(w -> head == w -> capacity) {
+        w -> head = 0;
+    }
+
+    w -> pending[WORKLIST_BYTE(tr)] &= ~WORKLIST_BIT(tr);
+
+    return tr;
+}
@@ -0,0 +1,77 @@
+
+#include <stdlib.h>
+
+#ifndef WORKLIST_H
+#define WORKLIST_H
+
+
+/*!
+@defgroup gr-worklist Worklist Data Structure
+
+@brief A fixed capacity FIFO of variable indexes used by the AC-3 loop.
+
+@details Unlike the generic queue, the worklist stores unsigned integer
+indexes directly in a ring buffer, so enqueueing and dequeueing never
+allocate memory. A per-index "pending" bit means an index which is already
+waiting in the worklist is not added a second time. Because of this the
+worklist never holds more than `capacity` items.
+
+@addtogroup gr-worklist
+@{
+*/
+
+/*!
+@brief A ring buffer of pending indexes with de-duplication.
+*/
+typedef struct worklist_t {
+    unsigned int  * items;      //<! Ring buffer of pending indexes.
+    unsigned char * pending;    //<! Bitmap, set iff index is in items.
+    unsigned int    capacity;   //<! Largest index + 1 that can be held.
+    unsigned int    head;       //<! Position of the next item to dequeue.
+    unsigned int    length;     //<! Number of items in the worklist.
+} worklist;
+
+
+/*!
+@brief Create a new empty worklist able to hold indexes 0..capacity-1.
+@param [in] capacity - One more than the largest index to be stored.
+@returns a new empty worklist.
+*/
+worklist * worklist_new(
+    unsigned int capacity
+);
+
+
+/*!
+@brief Free the memory allocated for a worklist.
+@param [in] tofree - The worklist to free.
+*/
+void worklist_free(
+    worklist * tofree
+);
+
+
+/*!
+@brief Add an index to the back of the worklist.
+@details Does nothing if the index is already pending.
+@param [in] w - The worklist to append to.
+@param [in] toadd - The index to add to the worklist.
+*/
+void worklist_enqueue(
+    worklist    * w,
+    unsigned int  toadd
+);
+
+
+/*!
+@brief Remove and return the index at the front of the worklist.
+@warning Must not be called on an empty worklist.
+@param [in] w - The worklist to remove things from.
+*/
+unsigned int worklist_dequeue(
+    worklist * w
+);
+
+/*! @} */
+
+#endif